@@ -5,6 +5,7 @@
 */
 
 #include "../src/lib/aztecbarcode.h"
+#include "../src/lib/barcodematrix_p.h"
 #include "../src/lib/bitvector_p.h"
 
 #include <prison.h>
@@ -15,6 +16,11 @@
 
 #include <memory>
 
+#ifdef HAVE_ZXING_DECODER
+#include <ZXing/ReadBarcode.h>
+#define ZXING_VERSION QT_VERSION_CHECK(ZXING_VERSION_MAJOR, ZXING_VERSION_MINOR, ZXING_VERSION_PATCH)
+#endif
+
 Q_DECLARE_METATYPE(Prison::BitVector)
 
 using namespace Prison;
@@ -22,6 +28,116 @@ using namespace Prison;
 class AztecBarcodeTest : public QObject
 {
     Q_OBJECT
+private:
+#ifdef HAVE_ZXING_DECODER
+    // decodes a symbol rendered at one pixel per module with ZXing, as a check of the
+    // encoder that doesn't depend on reference images produced by the encoder itself
+    static QByteArray zxingDecode(const QImage &img)
+    {
+        // ZXing needs a quiet zone, and a few pixels per module
+        constexpr int Scale = 4;
+        constexpr int Margin = 4 * Scale;
+        QImage scan(img.width() * Scale + 2 * Margin, img.height() * Scale + 2 * Margin, QImage::Format_Grayscale8);
+        scan.fill(0xff);
+        for (int y = 0; y < scan.height() - 2 * Margin; ++y) {
+            auto line = scan.scanLine(y + Margin) + Margin;
+            for (int x = 0; x < scan.width() - 2 * Margin; ++x) {
+                line[x] = qGray(img.pixel(x / Scale, y / Scale));
+            }
+        }
+
+        ZXing::DecodeHints hints;
+        hints.setFormats(ZXing::BarcodeFormat::Aztec);
+        const auto res = ZXing::ReadBarcode({scan.constBits(), scan.width(), scan.height(), ZXing::ImageFormat::Lum, int(scan.bytesPerLine())}, hints);
+        if (!res.isValid()) {
+            return {};
+        }
+#if ZXING_VERSION < QT_VERSION_CHECK(1, 4, 0)
+        // content without an ECI designator is ISO 8859-1
+        QByteArray content;
+        for (const auto c : res.text()) {
+            content.push_back(char(c));
+        }
+        return content;
+#else
+        return QByteArray(reinterpret_cast<const char *>(res.bytes().data()), int(res.bytes().size()));
+#endif
+    }
+#endif
+
+    // decodes the output of aztecEncode() back into its content, based on the character
+    // tables of the Aztec specification rather than on the encoder's own tables
+    static bool aztecDecode(const BitVector &v, QByteArray *out)
+    {
+        enum { Upper, Lower, Mixed, Punct, Digit };
+        static const QByteArray modeNames("ULMPD");
+        // control codes are in angle brackets, all other entries are one or two characters of content
+        static const char *const charTable[Digit + 1][32] = {
+            {"<P/S>", " ", "A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M", "N",
+             "O", "P", "Q", "R", "S", "T", "U", "V", "W", "X", "Y", "Z", "<L/L>", "<M/L>", "<D/L>", "<B/S>"},
+            {"<P/S>", " ", "a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m", "n",
+             "o", "p", "q", "r", "s", "t", "u", "v", "w", "x", "y", "z", "<U/S>", "<M/L>", "<D/L>", "<B/S>"},
+            {"<P/S>", " ", "\x01", "\x02", "\x03", "\x04", "\x05", "\x06", "\x07", "\x08", "\x09", "\x0a", "\x0b", "\x0c", "\x0d", "\x1b",
+             "\x1c", "\x1d", "\x1e", "\x1f", "@", "\\", "^", "_", "`", "|", "~", "\x7f", "<L/L>", "<U/L>", "<P/L>", "<B/S>"},
+            {"<FLG>", "\r", "\r\n", ". ", ", ", ": ", "!", "\"", "#", "$", "%", "&", "'", "(", ")", "*",
+             "+", ",", "-", ".", "/", ":", ";", "<", "=", ">", "?", "[", "]", "{", "}", "<U/L>"},
+            {"<P/S>", " ", "0", "1", "2", "3", "4", "5", "6", "7", "8", "9", ",", ".", "<U/L>", "<U/S>"},
+        };
+
+        int mode = Upper;
+        int shiftedFrom = -1;
+        int pos = 0;
+        const auto read = [&](int bits) {
+            const auto value = v.valueAtMSB(pos, bits);
+            pos += bits;
+            return value;
+        };
+
+        while (pos < v.size()) {
+            const auto codeSize = mode == Digit ? 4 : 5;
+            if (pos + codeSize > v.size()) {
+                return false;
+            }
+            const QByteArray entry(charTable[mode][read(codeSize)]);
+            if (entry.size() <= 2) {
+                out->append(entry);
+            } else if (entry == "<B/S>") {
+                if (pos + 5 > v.size()) {
+                    return false;
+                }
+                auto length = read(5);
+                if (length == 0) {
+                    if (pos + 11 > v.size()) {
+                        return false;
+                    }
+                    length = read(11) + 31;
+                }
+                if (pos + 8 * length > v.size()) {
+                    return false;
+                }
+                for (int i = 0; i < length; ++i) {
+                    out->append(char(read(8)));
+                }
+            } else if (entry.endsWith("/S>") && shiftedFrom < 0) {
+                shiftedFrom = mode;
+                mode = modeNames.indexOf(entry.at(1));
+                continue;
+            } else if (entry.endsWith("/L>") && shiftedFrom < 0) {
+                mode = modeNames.indexOf(entry.at(1));
+                continue;
+            } else {
+                // FLG(n) is never produced by the encoder, neither are shifts or latches right after a shift
+                return false;
+            }
+
+            if (shiftedFrom >= 0) {
+                mode = shiftedFrom;
+                shiftedFrom = -1;
+            }
+        }
+        return shiftedFrom < 0;
+    }
+
 private Q_SLOTS:
     void testAztecEncode_data()
     {
@@ -49,26 +165,55 @@ private Q_SLOTS:
         v.clear();
         v.appendMSB(28, 5);
         v.appendMSB(2, 5);
+        v.appendMSB(0, 5);
+        v.appendMSB(16, 5);
+        v.appendMSB(0, 5);
+        v.appendMSB(16, 5);
+        QTest::newRow("lower -> punct shift") << QByteArray("a++") << v;
+        v.clear();
+        v.appendMSB(28, 5);
+        v.appendMSB(2, 5);
         v.appendMSB(29, 5);
         v.appendMSB(30, 5);
         v.appendMSB(16, 5);
         v.appendMSB(16, 5);
-        QTest::newRow("lower -> punct latch") << QByteArray("a++") << v;
+        v.appendMSB(16, 5);
+        QTest::newRow("lower -> punct latch") << QByteArray("a+++") << v;
         v.clear();
         v.appendMSB(30, 5);
         v.appendMSB(6, 4);
         v.appendMSB(4, 4);
         QTest::newRow("digit") << QByteArray("42") << v;
         v.clear();
+        v.appendMSB(30, 5);
+        v.appendMSB(0, 4);
+        v.appendMSB(25, 5);
+        v.appendMSB(0, 4);
+        v.appendMSB(24, 5);
+        v.appendMSB(11, 4);
+        v.appendMSB(2, 4);
+        QTest::newRow("punct shift -> digit") << QByteArray(">=90") << v;
+        v.clear();
         v.appendMSB(29, 5);
         v.appendMSB(30, 5);
         v.appendMSB(25, 5);
         v.appendMSB(24, 5);
+        v.appendMSB(25, 5);
+        v.appendMSB(24, 5);
         v.appendMSB(31, 5);
         v.appendMSB(30, 5);
         v.appendMSB(11, 4);
         v.appendMSB(2, 4);
-        QTest::newRow("punct -> digit latch") << QByteArray(">=90") << v;
+        QTest::newRow("punct -> digit latch") << QByteArray(">=>=90") << v;
+        v.clear();
+        v.appendMSB(30, 5);
+        v.appendMSB(10, 4);
+        v.appendMSB(3, 4);
+        v.appendMSB(0, 4);
+        v.appendMSB(13, 5);
+        v.appendMSB(0, 4);
+        v.appendMSB(14, 5);
+        QTest::newRow("digit -> punct shift") << QByteArray("81()") << v;
         v.clear();
         v.appendMSB(30, 5);
         v.appendMSB(10, 4);
@@ -78,7 +223,9 @@ private Q_SLOTS:
         v.appendMSB(30, 5);
         v.appendMSB(13, 5);
         v.appendMSB(14, 5);
-        QTest::newRow("digit -> punct latch") << QByteArray("81()") << v;
+        v.appendMSB(29, 5);
+        v.appendMSB(30, 5);
+        QTest::newRow("digit -> punct latch") << QByteArray("81(){}") << v;
         v.clear();
         v.appendMSB(29, 5);
         v.appendMSB(11, 5);
@@ -89,7 +236,8 @@ private Q_SLOTS:
         v.appendMSB(30, 5);
         v.appendMSB(2, 5);
         v.appendMSB(2, 5);
-        QTest::newRow("CR LF") << QByteArray("\r\n\r\n") << v;
+        v.appendMSB(2, 5);
+        QTest::newRow("CR LF") << QByteArray("\r\n\r\n\r\n") << v;
         v.clear();
         v.appendMSB(31, 5);
         v.appendMSB(2, 5);
@@ -97,12 +245,22 @@ private Q_SLOTS:
         v.appendMSB(129, 8);
         QTest::newRow("binary") << QByteArray("\x80\x81") << v;
         v.clear();
+        QByteArray longBinary;
         v.appendMSB(31, 5);
-        v.appendMSB(2, 5);
+        v.appendMSB(0, 5);
+        v.appendMSB(70 - 31, 11);
+        for (int i = 0; i < 70; ++i) {
+            longBinary.push_back(char(0x80 + i));
+            v.appendMSB(0x80 + i, 8);
+        }
+        // shorter than three binary shifts of at most 31 bytes each
+        QTest::newRow("long binary") << longBinary << v;
+        v.clear();
+        v.appendMSB(31, 5);
+        v.appendMSB(3, 5);
         v.appendMSB(255, 8);
         v.appendMSB(254, 8);
-        v.appendMSB(28, 5);
-        v.appendMSB(3, 5);
+        v.appendMSB('b', 8); // cheaper than latching to Lower after the binary run
         QTest::newRow("binary/lower") << QByteArray(
             "\xff\xfe"
             "b") << v;
@@ -142,26 +300,20 @@ private Q_SLOTS:
         v.appendMSB(7, 4);
         QTest::newRow("digit ambiguous punct latch") << QByteArray(".5") << v;
         v.clear();
-        v.appendMSB(29, 5);
-        v.appendMSB(30, 5);
-        v.appendMSB(25, 5);
-        v.appendMSB(26, 5);
         v.appendMSB(31, 5);
-        v.appendMSB(29, 5);
-        v.appendMSB(20, 5);
-        v.appendMSB(29, 5);
+        v.appendMSB(3, 5);
+        v.appendMSB('>', 8);
+        v.appendMSB('?', 8);
+        v.appendMSB('@', 8);
         v.appendMSB(2, 5);
         QTest::newRow("punct/mixed/upper sequence") << QByteArray(">?@A") << v;
         v.clear();
         v.appendMSB(2, 5);
         v.appendMSB(3, 5);
         v.appendMSB(4, 5);
-        v.appendMSB(29, 5); // latch to Punct via latch to Mixed, shift to Punct directly would be more efficient here
-        v.appendMSB(30, 5);
-        v.appendMSB(19, 5);
-        v.appendMSB(31, 5); // latch to Upper due to shift to Binary not available in Punct
-        v.appendMSB(31, 5);
-        v.appendMSB(2, 5);
+        v.appendMSB(31, 5); // '.' is cheaper as part of the binary run than via a shift to Punct
+        v.appendMSB(3, 5);
+        v.appendMSB('.', 8);
         v.appendMSB(0, 8);
         v.appendMSB(0, 8);
         QTest::newRow("upper/special -> binary") << QByteArray("ABC.\x00\x00", 6) << v;
@@ -181,6 +333,44 @@ private Q_SLOTS:
         QCOMPARE(v, output);
     }
 
+    void testAztecEncodeLong_data()
+    {
+        QTest::addColumn<QByteArray>("input");
+        QTest::addColumn<int>("outputSize");
+
+        // long enough for the encoder to write the result in several parts
+        QTest::newRow("text") << QByteArray("Aztec 2D barcode, KDE Frameworks 5! ").repeated(40) << 8756;
+        QByteArray mixed;
+        for (int i = 0; i < 500; ++i) {
+            mixed += QByteArray::number(i * 7919);
+            mixed += (i % 3) ? ", " : "x\r\n";
+        }
+        QTest::newRow("mixed") << mixed << 20765;
+        QByteArray binary;
+        for (int i = 0; i < 3000; ++i) {
+            binary.push_back(char(i * 37 + (i >> 5)));
+        }
+        QTest::newRow("binary") << binary << 24036;
+        QByteArray binaryText;
+        for (int i = 0; i < 3000; ++i) {
+            binaryText.push_back(i % 80 < 40 ? char(0x80 + i % 40) : "KDE Frameworks 5 and Prison.\n\r0123456789"[i % 40]);
+        }
+        QTest::newRow("binary/text") << binaryText << 21615;
+    }
+
+    void testAztecEncodeLong()
+    {
+        QFETCH(QByteArray, input);
+        QFETCH(int, outputSize);
+
+        AztecBarcode code;
+        const auto v = code.aztecEncode(input);
+        QCOMPARE(v.size(), outputSize);
+        QByteArray decoded;
+        QVERIFY(aztecDecode(v, &decoded));
+        QCOMPARE(decoded, input);
+    }
+
     void testStuffAndPad_data()
     {
         QTest::addColumn<BitVector>("input");
@@ -225,29 +415,95 @@ private Q_SLOTS:
         QCOMPARE(res, output);
     }
 
-    void testFullGrid()
+    void testSelectLayout_data()
+    {
+        QTest::addColumn<int>("bitCount");
+        QTest::addColumn<bool>("allZero");
+        QTest::addColumn<int>("errorCorrectionPercent");
+        QTest::addColumn<bool>("fits");
+        QTest::addColumn<int>("layerCount");
+        QTest::addColumn<bool>("compact");
+
+        // alternating bits don't need stuffing, so these are the capacity limits leaving 23% for error correction
+        QTest::newRow("compact 1 max") << 80 << false << 23 << true << 1 << true;
+        QTest::newRow("compact 2 min") << 81 << false << 23 << true << 2 << true;
+        QTest::newRow("compact 2 max, last 6 bit code words") << 184 << false << 23 << true << 2 << true;
+        QTest::newRow("compact 3 min, first 8 bit code words") << 185 << false << 23 << true << 3 << true;
+        QTest::newRow("compact 4 max") << 468 << false << 23 << true << 4 << true;
+        QTest::newRow("full 4 after compact") << 469 << false << 23 << true << 4 << false;
+        QTest::newRow("full 8 max, last 8 bit code words") << 1478 << false << 23 << true << 8 << false;
+        QTest::newRow("full 9 min, first 10 bit code words") << 1479 << false << 23 << true << 9 << false;
+        QTest::newRow("full 22 max, last 10 bit code words") << 7860 << false << 23 << true << 22 << false;
+        QTest::newRow("full 23 min, first 12 bit code words") << 7861 << false << 23 << true << 23 << false;
+        QTest::newRow("full 32 max") << 15375 << false << 23 << true << 32 << false;
+        QTest::newRow("too large") << 15376 << false << 23 << false << 0 << false;
+
+        // all zero input gets one stuffed bit per code word
+        QTest::newRow("compact 64 code words") << 448 << true << 23 << true << 4 << true;
+        QTest::newRow("compact 65 code words") << 449 << true << 23 << true << 4 << false;
+        // stuffing leaves no room for error correction in the smallest layer fitting the unstuffed data
+        QTest::newRow("stuffing into compact 2") << 81 << true << 10 << true << 2 << true;
+        QTest::newRow("stuffing into compact 3") << 196 << true << 10 << true << 3 << true;
+        QTest::newRow("stuffing into compact 4") << 351 << true << 10 << true << 4 << true;
+    }
+
+    void testSelectLayout()
     {
+        QFETCH(int, bitCount);
+        QFETCH(bool, allZero);
+        QFETCH(int, errorCorrectionPercent);
+        QFETCH(bool, fits);
+        QFETCH(int, layerCount);
+        QFETCH(bool, compact);
+
+        BitVector input;
+        for (int i = 0; i < bitCount; ++i) {
+            input.appendBit(!allZero && i % 2 == 0);
+        }
+
         AztecBarcode code;
-        QImage img(151, 151, QImage::Format_ARGB32_Premultiplied);
-        img.fill(code.backgroundColor());
-        code.paintFullGrid(&img);
+        AztecOptions options;
+        options.errorCorrectionPercent = errorCorrectionPercent;
+        code.setAztecOptions(options);
+
+        int selectedLayerCount = 0;
+        bool selectedCompact = false;
+        BitVector stuffedData;
+        QCOMPARE(code.selectLayout(input, &selectedLayerCount, &selectedCompact, &stuffedData), fits);
+        if (fits) {
+            QCOMPARE(selectedLayerCount, layerCount);
+            QCOMPARE(selectedCompact, compact);
+            QCOMPARE(stuffedData, code.bitStuffAndPad(input, layerCount <= 2 ? 6 : layerCount <= 8 ? 8 : layerCount <= 22 ? 10 : 12));
+        }
+    }
 
+    void testFullGrid()
+    {
+        const auto &img = AztecBarcode::fullTemplate(32);
         QImage ref(QStringLiteral(":/aztec/rendering/aztec-full-grid.png"));
-        ref = ref.convertToFormat(img.format());
-        QCOMPARE(img, ref);
+        QCOMPARE(img.convertToFormat(ref.format()), ref);
+
+        // smaller symbols are the center of the largest one
+        for (int i = 1; i < 32; ++i) {
+            const auto &t = AztecBarcode::fullTemplate(i);
+            const auto offset = (img.width() - t.width()) / 2;
+            QCOMPARE(t, img.copy(offset, offset, t.width(), t.height()));
+        }
     }
 
     void testCompactGrid()
     {
-        AztecBarcode code;
-        QImage img(27, 27, QImage::Format_ARGB32_Premultiplied);
-        img.fill(code.backgroundColor());
-        code.paintCompactGrid(&img);
+        const auto &img = AztecBarcode::compactTemplate(4);
         img.save(QStringLiteral("aztec-compact-grid.png"));
 
         QImage ref(QStringLiteral(":/aztec/rendering/aztec-compact-grid.png"));
-        ref = ref.convertToFormat(img.format());
-        QCOMPARE(img, ref);
+        QCOMPARE(img.convertToFormat(ref.format()), ref);
+
+        for (int i = 1; i < 4; ++i) {
+            const auto &t = AztecBarcode::compactTemplate(i);
+            const auto offset = (img.width() - t.width()) / 2;
+            QCOMPARE(t, img.copy(offset, offset, t.width(), t.height()));
+        }
     }
 
     void testFullData_data()
@@ -294,14 +550,12 @@ private Q_SLOTS:
         QFETCH(int, layer);
 
         AztecBarcode code;
-        QImage img(151, 151, QImage::Format_ARGB32_Premultiplied);
-        img.fill(code.backgroundColor());
+        auto img = BarcodeMatrixPrivate::createModuleImage(151, 151);
         code.paintFullData(&img, data, layer);
         img.save(refName);
 
         QImage ref(QStringLiteral(":/aztec/rendering/") + refName);
-        ref = ref.convertToFormat(img.format());
-        QCOMPARE(img, ref);
+        QCOMPARE(img.convertToFormat(ref.format()), ref);
     }
 
     void testFullModeMessage_data()
@@ -334,14 +588,12 @@ private Q_SLOTS:
         QFETCH(QString, refName);
 
         AztecBarcode code;
-        QImage img(151, 151, QImage::Format_ARGB32_Premultiplied);
-        img.fill(code.backgroundColor());
+        auto img = BarcodeMatrixPrivate::createModuleImage(151, 151);
         code.paintFullModeMessage(&img, data);
         img.save(refName);
 
         QImage ref(QStringLiteral(":/aztec/rendering/") + refName);
-        ref = ref.convertToFormat(img.format());
-        QCOMPARE(img, ref);
+        QCOMPARE(img.convertToFormat(ref.format()), ref);
     }
 
     void testCompactData_data()
@@ -388,14 +640,12 @@ private Q_SLOTS:
         QFETCH(int, layer);
 
         AztecBarcode code;
-        QImage img(27, 27, QImage::Format_ARGB32_Premultiplied);
-        img.fill(code.backgroundColor());
+        auto img = BarcodeMatrixPrivate::createModuleImage(27, 27);
         code.paintCompactData(&img, data, layer);
         img.save(refName);
 
         QImage ref(QStringLiteral(":/aztec/rendering/") + refName);
-        ref = ref.convertToFormat(img.format());
-        QCOMPARE(img, ref);
+        QCOMPARE(img.convertToFormat(ref.format()), ref);
     }
 
     void testCompactModeMessage_data()
@@ -428,14 +678,12 @@ private Q_SLOTS:
         QFETCH(QString, refName);
 
         AztecBarcode code;
-        QImage img(151, 151, QImage::Format_ARGB32_Premultiplied);
-        img.fill(code.backgroundColor());
+        auto img = BarcodeMatrixPrivate::createModuleImage(151, 151);
         code.paintCompactModeMessage(&img, data);
         img.save(refName);
 
         QImage ref(QStringLiteral(":/aztec/rendering/") + refName);
-        ref = ref.convertToFormat(img.format());
-        QCOMPARE(img, ref);
+        QCOMPARE(img.convertToFormat(ref.format()), ref);
     }
 
     void testCodeGen_data()
@@ -476,26 +724,162 @@ private Q_SLOTS:
         QFETCH(QByteArray, input);
         QFETCH(QString, refName);
 
+        // the reference images are produced by the encoder itself, so also check the content
+        // and the error correction independently of them, in every build
+        {
+            AztecBarcode code;
+            QByteArray decoded;
+            QVERIFY(aztecDecode(code.aztecEncode(input), &decoded));
+            QCOMPARE(decoded, input);
+        }
+
         {
             AztecBarcode code;
             code.setData(QString::fromLatin1(input.constData(), input.size()));
-            const auto img = code.paintImage({});
+            const auto img = code.toImage(code.trueMinimumSize());
             img.save(refName);
 
             QImage ref(QStringLiteral(":/aztec/encoding/") + refName);
             ref = ref.convertToFormat(img.format());
             QCOMPARE(img, ref);
+
+            QVERIFY(AztecBarcode::verifySymbol(code.paintImage({}), code.symbolInfo().compact));
+#ifdef HAVE_ZXING_DECODER
+            QCOMPARE(zxingDecode(img), input);
+#endif
         }
 
         {
             AztecBarcode code;
             code.setData(input);
-            const auto img = code.paintImage({});
+            const auto img = code.toImage(code.trueMinimumSize());
             img.save(refName);
 
             QImage ref(QStringLiteral(":/aztec/encoding/") + refName);
             ref = ref.convertToFormat(img.format());
             QCOMPARE(img, ref);
+
+            QVERIFY(AztecBarcode::verifySymbol(code.paintImage({}), code.symbolInfo().compact));
+#ifdef HAVE_ZXING_DECODER
+            QCOMPARE(zxingDecode(img), input);
+#endif
+        }
+    }
+
+    void testVerifyCodewords_data()
+    {
+        testCodeGen_data();
+    }
+
+    void testVerifyCodewords()
+    {
+        QFETCH(QByteArray, input);
+
+        AztecBarcode code;
+        code.setData(input);
+        BitVector encodedData;
+        BitVector modeMsg;
+        int layerCount = 0;
+        bool compactMode = false;
+        QVERIFY(code.encodeSymbol(&encodedData, &modeMsg, &layerCount, &compactMode));
+        QVERIFY(AztecBarcode::verifyCodewords(encodedData, modeMsg, compactMode));
+        QVERIFY(!AztecBarcode::verifyCodewords(encodedData, modeMsg, !compactMode));
+
+        // flip the last bit, which is always part of an error correction code word
+        const auto flipLastBit = [](const BitVector &v) {
+            BitVector res;
+            for (int i = 0; i < v.size(); ++i) {
+                res.appendBit(v.at(i) != (i == v.size() - 1));
+            }
+            return res;
+        };
+        QVERIFY(!AztecBarcode::verifyCodewords(flipLastBit(encodedData), modeMsg, compactMode));
+        QVERIFY(!AztecBarcode::verifyCodewords(encodedData, flipLastBit(modeMsg), compactMode));
+    }
+
+    void testVerifySymbol_data()
+    {
+        testCodeGen_data();
+    }
+
+    void testVerifySymbol()
+    {
+        QFETCH(QByteArray, input);
+
+        AztecBarcode code;
+        code.setData(input);
+        const auto compactMode = code.symbolInfo().compact;
+        auto img = code.paintImage({});
+        QVERIFY(AztecBarcode::verifySymbol(img, compactMode));
+        QVERIFY(!AztecBarcode::verifySymbol(img, !compactMode));
+
+        // the left-most module just above the center is always part of a data code word
+        img.scanLine(img.height() / 2 - 1)[0] ^= 0x80;
+        QVERIFY(!AztecBarcode::verifySymbol(img, compactMode));
+    }
+
+    void testOptions_data()
+    {
+        QTest::addColumn<QByteArray>("input");
+        QTest::addColumn<int>("errorCorrectionPercent");
+        QTest::addColumn<int>("format");
+        QTest::addColumn<int>("minimumLayerCount");
+        QTest::addColumn<int>("maximumLayerCount");
+        QTest::addColumn<bool>("fits");
+        QTest::addColumn<int>("layerCount");
+        QTest::addColumn<bool>("compact");
+
+        const QByteArray shortInput("KF5::Prison");
+        const QByteArray compactInput("KF5::Prison - the barcode generation library of KDE Frameworks 5!");
+        const QByteArray fullInput("KF5::Prison - the MIT licensed free software barcode generation library of KDE Frameworks 5!");
+
+        QTest::newRow("default") << shortInput << 23 << (int)AztecOptions::AnyFormat << 1 << 32 << true << 1 << true;
+        QTest::newRow("full") << shortInput << 23 << (int)AztecOptions::FullFormat << 1 << 32 << true << 1 << false;
+        QTest::newRow("min layers") << shortInput << 23 << (int)AztecOptions::AnyFormat << 3 << 32 << true << 3 << true;
+        QTest::newRow("min layers beyond compact") << shortInput << 23 << (int)AztecOptions::AnyFormat << 6 << 32 << true << 6 << false;
+        QTest::newRow("low ecc") << compactInput << 5 << (int)AztecOptions::AnyFormat << 1 << 32 << true << 3 << true;
+        QTest::newRow("high ecc") << compactInput << 50 << (int)AztecOptions::AnyFormat << 1 << 32 << true << 5 << false;
+        QTest::newRow("max layers") << compactInput << 23 << (int)AztecOptions::AnyFormat << 1 << 3 << false << 0 << false;
+        QTest::newRow("compact too small") << fullInput << 23 << (int)AztecOptions::CompactFormat << 1 << 32 << false << 0 << false;
+        // fits into the compact capacity, but exceeds the 64 data code words the compact mode message can represent
+        QTest::newRow("compact code word limit") << fullInput << 5 << (int)AztecOptions::CompactFormat << 1 << 32 << false << 0 << false;
+    }
+
+    void testOptions()
+    {
+        QFETCH(QByteArray, input);
+        QFETCH(int, errorCorrectionPercent);
+        QFETCH(int, format);
+        QFETCH(int, minimumLayerCount);
+        QFETCH(int, maximumLayerCount);
+        QFETCH(bool, fits);
+        QFETCH(int, layerCount);
+        QFETCH(bool, compact);
+
+        AztecOptions options;
+        options.errorCorrectionPercent = errorCorrectionPercent;
+        options.format = AztecOptions::Format(format);
+        options.minimumLayerCount = minimumLayerCount;
+        options.maximumLayerCount = maximumLayerCount;
+
+        AztecBarcode code;
+        code.setData(input);
+        code.setAztecOptions(options);
+        QCOMPARE(code.aztecOptions(), options);
+
+        const auto info = code.symbolInfo();
+        QCOMPARE(info.fits, fits);
+        QCOMPARE(info.version, layerCount);
+        QCOMPARE(info.compact, compact);
+
+        const auto img = code.paintImage({});
+        QCOMPARE(img.isNull(), !fits);
+        if (fits) {
+            QCOMPARE(img.size(), info.size);
+            QVERIFY(AztecBarcode::verifySymbol(img, compact));
+#ifdef HAVE_ZXING_DECODER
+            QCOMPARE(zxingDecode(code.toImage(code.trueMinimumSize())), input);
+#endif
         }
     }
 
@@ -0,0 +1,442 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: MIT
+*/
+
+#include <prison.h>
+
+#include <QBuffer>
+#include <QColor>
+#include <QImage>
+#include <QObject>
+#include <QPainter>
+#include <QRegularExpression>
+#include <QTest>
+
+#include <memory>
+#include <vector>
+
+using namespace Prison;
+
+Q_DECLARE_METATYPE(Prison::BarcodeType)
+
+// fixed module pattern, with a width filling entire 32 bit words and identical consecutive rows
+class PatternBarcode : public AbstractBarcode
+{
+public:
+    PatternBarcode()
+        : AbstractBarcode(AbstractBarcode::TwoDimensions)
+    {
+    }
+
+    static bool module(int x, int y)
+    {
+        return y < 2 ? (x % 3 == 0) : (x % 5 == 1);
+    }
+
+protected:
+    QImage paintImage(const QSizeF &size) override
+    {
+        Q_UNUSED(size);
+        QImage img(64, 4, QImage::Format_Mono);
+        img.setColorTable({qRgb(0xff, 0xff, 0xff), qRgb(0, 0, 0)});
+        for (int y = 0; y < img.height(); ++y) {
+            for (int x = 0; x < img.width(); ++x) {
+                img.setPixel(x, y, module(x, y) ? 1 : 0);
+            }
+        }
+        return img;
+    }
+};
+
+class BarcodeMatrixTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testNull()
+    {
+        BarcodeMatrix m;
+        QVERIFY(m.isNull());
+        QCOMPARE(m.size(), QSize(0, 0));
+        QCOMPARE(m.width(), 0);
+        QCOMPARE(m.height(), 0);
+
+        std::unique_ptr<AbstractBarcode> code(createBarcode(QRCode));
+        QVERIFY(code->matrix().isNull());
+        code->setData(QStringLiteral("KF5::Prison"));
+        QVERIFY(!code->matrix().isNull());
+        code->setData(QString());
+        QVERIFY(code->matrix().isNull());
+    }
+
+    void testMatrix_data()
+    {
+        QTest::addColumn<Prison::BarcodeType>("type");
+        QTest::newRow("QRCode") << QRCode;
+        QTest::newRow("DataMatrix") << DataMatrix;
+        QTest::newRow("Aztec") << Aztec;
+        QTest::newRow("Code39") << Code39;
+        QTest::newRow("Code93") << Code93;
+        QTest::newRow("Code128") << Code128;
+        QTest::newRow("PDF417") << PDF417;
+    }
+
+    void testMatrix()
+    {
+        QFETCH(Prison::BarcodeType, type);
+        std::unique_ptr<AbstractBarcode> code(createBarcode(type));
+        if (!code) {
+            QSKIP("barcode type not supported in this build");
+        }
+
+        code->setData(QStringLiteral("KF5PRISON"));
+        const auto m = code->matrix();
+        QVERIFY(!m.isNull());
+        QCOMPARE(QSizeF(m.size()), code->trueMinimumSize());
+        QVERIFY(m.bytesPerLine() * 8 >= m.width());
+        if (code->dimensions() == AbstractBarcode::OneDimension) {
+            QCOMPARE(m.height(), 1);
+        }
+
+        // repeated access returns the same content
+        QCOMPARE(code->matrix(), m);
+
+        // the rendered image is the colorized matrix
+        code->setForegroundColor(Qt::red);
+        code->setBackgroundColor(Qt::yellow);
+        const auto img = code->toImage(code->trueMinimumSize());
+        QCOMPARE(img.size(), m.size());
+        int setModules = 0;
+        for (int y = 0; y < m.height(); ++y) {
+            for (int x = 0; x < m.width(); ++x) {
+                QCOMPARE(QColor(img.pixel(x, y)), m.module(x, y) ? QColor(Qt::red) : QColor(Qt::yellow));
+                setModules += m.module(x, y) ? 1 : 0;
+                QCOMPARE(m.module(x, y), bool(m.constScanLine(y)[x / 8] & (0x80 >> (x % 8))));
+            }
+        }
+        QVERIFY(setModules > 0);
+        QVERIFY(setModules < m.width() * m.height());
+
+        // colors don't affect the modules
+        QCOMPARE(code->matrix(), m);
+    }
+
+    void testScaledRender_data()
+    {
+        testMatrix_data();
+    }
+
+    void testScaledRender()
+    {
+        QFETCH(Prison::BarcodeType, type);
+        std::unique_ptr<AbstractBarcode> code(createBarcode(type));
+        if (!code) {
+            QSKIP("barcode type not supported in this build");
+        }
+
+        code->setData(QStringLiteral("KF5PRISON"));
+        code->setBackgroundColor(Qt::transparent);
+        const auto m = code->matrix();
+        const auto scaleX = 3;
+        const auto scaleY = code->dimensions() == AbstractBarcode::OneDimension ? 7 : 3;
+        const auto img = code->toImage(QSizeF(m.width() * scaleX + 2, m.height() * scaleY));
+        QCOMPARE(img.size(), QSize(m.width() * scaleX, m.height() * scaleY));
+        for (int y = 0; y < img.height(); ++y) {
+            for (int x = 0; x < img.width(); ++x) {
+                QCOMPARE(img.pixel(x, y), m.module(x / scaleX, y / scaleY) ? QColor(Qt::black).rgba() : QColor(Qt::transparent).rgba());
+            }
+        }
+
+        // scale 1 returns the cached image
+        const auto img1 = code->toImage(code->trueMinimumSize());
+        QCOMPARE(img1.cacheKey(), code->toImage(code->trueMinimumSize()).cacheKey());
+    }
+
+    void testRenderTo_data()
+    {
+        QTest::addColumn<Prison::BarcodeType>("type");
+        QTest::addColumn<int>("formatValue");
+        for (const auto format : {QImage::Format_Mono,
+                                  QImage::Format_Grayscale8,
+                                  QImage::Format_Indexed8,
+                                  QImage::Format_RGB32,
+                                  QImage::Format_ARGB32,
+                                  QImage::Format_ARGB32_Premultiplied}) {
+            QTest::newRow(QByteArray("QRCode-" + QByteArray::number(format)).constData()) << QRCode << int(format);
+            QTest::newRow(QByteArray("Code128-" + QByteArray::number(format)).constData()) << Code128 << int(format);
+        }
+    }
+
+    void testRenderTo()
+    {
+        QFETCH(Prison::BarcodeType, type);
+        QFETCH(int, formatValue);
+        const auto format = static_cast<QImage::Format>(formatValue);
+        std::unique_ptr<AbstractBarcode> code(createBarcode(type));
+        code->setData(QStringLiteral("KF5PRISON"));
+        const auto m = code->matrix();
+
+        // larger than the barcode, with an odd width for Mono, and some extra space at the end of each line
+        for (const auto scale : {1, 3}) {
+            const QSize size(m.width() * scale + 5, m.height() * scale + 3);
+            const auto bytesPerLine = (size.width() * QImage::toPixelFormat(format).bitsPerPixel() + 7) / 8 + 5;
+            QByteArray buffer(bytesPerLine * size.height(), 0x55);
+            QVERIFY(code->renderTo(reinterpret_cast<uchar *>(buffer.data()), size, bytesPerLine, format));
+
+            QImage img(reinterpret_cast<const uchar *>(buffer.constData()), size.width(), size.height(), bytesPerLine, format);
+            if (format == QImage::Format_Mono || format == QImage::Format_Indexed8) {
+                img.setColorTable({qRgb(0xff, 0xff, 0xff), qRgb(0, 0, 0)});
+            }
+            img = img.convertToFormat(QImage::Format_ARGB32);
+
+            const auto expected = code->toImage(size);
+            const auto scaleY = code->dimensions() == AbstractBarcode::OneDimension ? size.height() / m.height() : scale;
+            QCOMPARE(expected.size(), QSize(m.width() * scale, m.height() * scaleY));
+            for (int y = 0; y < size.height(); ++y) {
+                for (int x = 0; x < size.width(); ++x) {
+                    const auto inside = x < expected.width() && y < expected.height();
+                    QCOMPARE(img.pixel(x, y), inside ? expected.pixel(x, y) : qRgb(0xff, 0xff, 0xff));
+                }
+            }
+
+            // the line padding is left untouched
+            for (int y = 0; y < size.height(); ++y) {
+                QCOMPARE(buffer.at(y * bytesPerLine + bytesPerLine - 1), char(0x55));
+            }
+        }
+    }
+
+    void testRenderWordAligned_data()
+    {
+        QTest::addColumn<int>("formatValue");
+        QTest::newRow("Mono") << int(QImage::Format_Mono);
+        QTest::newRow("Grayscale8") << int(QImage::Format_Grayscale8);
+        QTest::newRow("ARGB32") << int(QImage::Format_ARGB32);
+    }
+
+    void testRenderWordAligned()
+    {
+        QFETCH(int, formatValue);
+        const auto format = static_cast<QImage::Format>(formatValue);
+        PatternBarcode code;
+        code.setData(QStringLiteral("pattern"));
+        const auto m = code.matrix();
+        QCOMPARE(m.size(), QSize(64, 4));
+
+        for (const auto scale : {1, 2}) {
+            const QSize size(m.width() * scale, m.height() * scale);
+            QImage img(size, format);
+            if (format == QImage::Format_Mono) {
+                img.setColorTable({qRgb(0xff, 0xff, 0xff), qRgb(0, 0, 0)});
+            }
+            QVERIFY(code.renderTo(img.bits(), size, img.bytesPerLine(), format));
+            img = img.convertToFormat(QImage::Format_ARGB32);
+            for (int y = 0; y < size.height(); ++y) {
+                for (int x = 0; x < size.width(); ++x) {
+                    QCOMPARE(img.pixel(x, y), PatternBarcode::module(x / scale, y / scale) ? qRgb(0, 0, 0) : qRgb(0xff, 0xff, 0xff));
+                }
+            }
+            QCOMPARE(code.toImage(size).convertToFormat(QImage::Format_ARGB32), img);
+        }
+    }
+
+    void testRenderToInvalid()
+    {
+        std::unique_ptr<AbstractBarcode> code(createBarcode(QRCode));
+        QByteArray buffer(1000 * 1000, 0);
+        auto data = reinterpret_cast<uchar *>(buffer.data());
+        QVERIFY(!code->renderTo(data, QSize(100, 100), 400, QImage::Format_ARGB32));
+
+        code->setData(QStringLiteral("KF5PRISON"));
+        QVERIFY(code->renderTo(data, QSize(100, 100), 400, QImage::Format_ARGB32));
+        QVERIFY(!code->renderTo(data, QSize(100, 100), 399, QImage::Format_ARGB32));
+        QVERIFY(!code->renderTo(data, QSize(10, 10), 40, QImage::Format_ARGB32));
+        QVERIFY(!code->renderTo(data, QSize(100, 100), 400, QImage::Format_RGB16));
+        QVERIFY(!code->renderTo(nullptr, QSize(100, 100), 400, QImage::Format_ARGB32));
+    }
+
+    void testWriteVector_data()
+    {
+        testMatrix_data();
+    }
+
+    void testWriteVector()
+    {
+        QFETCH(Prison::BarcodeType, type);
+        std::unique_ptr<AbstractBarcode> code(createBarcode(type));
+        if (!code) {
+            QSKIP("barcode type not supported in this build");
+        }
+        code->setData(QStringLiteral("KF5PRISON"));
+        const auto m = code->matrix();
+
+        // decode the SVG path back into modules
+        QBuffer svg;
+        svg.open(QIODevice::WriteOnly);
+        QVERIFY(code->writeVector(&svg, AbstractBarcode::SvgFormat, QSizeF(m.width() * 2, m.height() * 2)));
+        const auto svgData = svg.data();
+        QVERIFY(svgData.startsWith("<?xml"));
+        QVERIFY(svgData.contains("viewBox=\"0 0 " + QByteArray::number(m.width()) + ' ' + QByteArray::number(m.height()) + '"'));
+        const QRegularExpression pathRx(QStringLiteral("d=\"([^\"]*)\""));
+        const auto path = pathRx.match(QString::fromUtf8(svgData)).captured(1);
+        QVERIFY(!path.isEmpty());
+
+        std::vector<int> coverage(m.width() * m.height(), 0);
+        const QRegularExpression rectRx(QStringLiteral("M(\\d+) (\\d+)h(\\d+)v(\\d+)h-(\\d+)z"));
+        int rectCount = 0;
+        for (auto it = rectRx.globalMatch(path); it.hasNext(); ++rectCount) {
+            const auto match = it.next();
+            const auto x = match.captured(1).toInt();
+            const auto y = match.captured(2).toInt();
+            const auto w = match.captured(3).toInt();
+            const auto h = match.captured(4).toInt();
+            QCOMPARE(match.captured(5).toInt(), w);
+            QVERIFY(x + w <= m.width() && y + h <= m.height());
+            for (int i = y; i < y + h; ++i) {
+                for (int j = x; j < x + w; ++j) {
+                    ++coverage[i * m.width() + j];
+                }
+            }
+        }
+        int setModules = 0;
+        for (int y = 0; y < m.height(); ++y) {
+            for (int x = 0; x < m.width(); ++x) {
+                QCOMPARE(coverage[y * m.width() + x], m.module(x, y) ? 1 : 0);
+                setModules += m.module(x, y) ? 1 : 0;
+            }
+        }
+        QVERIFY(rectCount < setModules);
+
+        QBuffer eps;
+        eps.open(QIODevice::WriteOnly);
+        QVERIFY(code->writeVector(&eps, AbstractBarcode::EpsFormat));
+        QVERIFY(eps.data().startsWith("%!PS-Adobe-3.0 EPSF-3.0\n"));
+        QCOMPARE(eps.data().count(" R\n"), rectCount + 1); // including the background
+
+        QBuffer pdf;
+        pdf.open(QIODevice::WriteOnly);
+        QVERIFY(code->writeVector(&pdf, AbstractBarcode::PdfFormat));
+        const auto pdfData = pdf.data();
+        QVERIFY(pdfData.startsWith("%PDF-1.4\n"));
+        QVERIFY(pdfData.endsWith("%%EOF\n"));
+        QCOMPARE(pdfData.count(" re\n"), rectCount);
+        // xref offsets point to the objects
+        const auto xref = pdfData.lastIndexOf("xref\n");
+        const auto startXref = pdfData.lastIndexOf("startxref\n");
+        QCOMPARE(pdfData.mid(startXref + 10).split('\n').at(0).toInt(), xref);
+        const auto xrefEntries = pdfData.mid(xref).split('\n');
+        for (int i = 1; i <= 4; ++i) {
+            const auto offset = xrefEntries.at(2 + i).left(10).toInt();
+            QVERIFY(pdfData.mid(offset).startsWith(QByteArray::number(i) + " 0 obj\n"));
+        }
+
+        // transparent backgrounds are omitted
+        code->setBackgroundColor(Qt::transparent);
+        eps.close();
+        eps.setData(QByteArray());
+        eps.open(QIODevice::WriteOnly);
+        QVERIFY(code->writeVector(&eps, AbstractBarcode::EpsFormat));
+        QCOMPARE(eps.data().count(" R\n"), rectCount);
+
+        std::unique_ptr<AbstractBarcode> empty(createBarcode(type));
+        QVERIFY(!empty->writeVector(&eps, AbstractBarcode::SvgFormat));
+    }
+
+    void testPaint_data()
+    {
+        testMatrix_data();
+    }
+
+    void testPaint()
+    {
+        QFETCH(Prison::BarcodeType, type);
+        std::unique_ptr<AbstractBarcode> code(createBarcode(type));
+        if (!code) {
+            QSKIP("barcode type not supported in this build");
+        }
+        code->setData(QStringLiteral("KF5PRISON"));
+        code->setForegroundColor(Qt::blue);
+        const auto m = code->matrix();
+
+        // painting the same area as toImage() produces the identical result
+        const auto expected = code->toImage(code->preferredSize(1));
+        for (const qreal scale : {1.0, 2.0}) {
+            QImage img(expected.width() + 20, expected.height() + 20, QImage::Format_ARGB32);
+            img.fill(Qt::red);
+            {
+                QPainter p(&img);
+                p.scale(scale, scale);
+                code->paint(&p, QRectF(QPointF(10, 10) / scale, QSizeF(expected.size()) / scale));
+            }
+            QCOMPARE(img.copy(10, 10, expected.width(), expected.height()), expected);
+            QCOMPARE(img.pixel(9, 9), QColor(Qt::red).rgba());
+            QCOMPARE(img.pixel(expected.width() + 10, expected.height() + 10), QColor(Qt::red).rgba());
+        }
+
+        // fractional target rectangles still result in module sizes of full pixels, without anti-aliasing
+        QImage img(m.width() * 4 + 10, m.height() * 4 + 40, QImage::Format_ARGB32);
+        img.fill(Qt::red);
+        {
+            QPainter p(&img);
+            p.setRenderHint(QPainter::Antialiasing);
+            code->paint(&p, QRectF(3.3, 7.7, m.width() * 3.5, m.height() * 3.5 + 20.2));
+        }
+        for (int y = 0; y < img.height(); ++y) {
+            for (int x = 0; x < img.width(); ++x) {
+                const auto c = img.pixel(x, y);
+                QVERIFY(c == QColor(Qt::red).rgba() || c == QColor(Qt::blue).rgba() || c == QColor(Qt::white).rgba());
+            }
+        }
+        int minX = img.width(), maxX = -1;
+        for (int x = 0; x < img.width(); ++x) {
+            for (int y = 0; y < img.height(); ++y) {
+                if (img.pixel(x, y) != QColor(Qt::red).rgba()) {
+                    minX = std::min(minX, x);
+                    maxX = std::max(maxX, x);
+                }
+            }
+        }
+        QCOMPARE(maxX - minX + 1, m.width() * 3);
+
+        // too small
+        img.fill(Qt::red);
+        {
+            QPainter p(&img);
+            code->paint(&p, QRectF(0, 0, m.width() - 1, m.height() - 1));
+        }
+        QCOMPARE(img.pixel(0, 0), QColor(Qt::red).rgba());
+    }
+
+    void testImageCache()
+    {
+        std::unique_ptr<AbstractBarcode> code(createBarcode(QRCode));
+        code->setData(QStringLiteral("KF5::Prison"));
+
+        const auto size = code->preferredSize(1);
+        const auto img = code->toImage(size);
+        QCOMPARE(code->toImage(size).cacheKey(), img.cacheKey());
+        // sizes resulting in the same scale share the image
+        QCOMPARE(code->toImage(size + QSizeF(1, 1)).cacheKey(), img.cacheKey());
+
+        // a few other sizes are kept as well
+        const auto img2 = code->toImage(size * 2);
+        QCOMPARE(code->toImage(size).cacheKey(), img.cacheKey());
+        QCOMPARE(code->toImage(size * 2).cacheKey(), img2.cacheKey());
+
+        // color changes invalidate the cache, but don't require encoding again
+        const auto modules = code->matrix().constScanLine(0);
+        code->setForegroundColor(Qt::blue);
+        QVERIFY(code->matrix().constScanLine(0) == modules);
+        const auto img3 = code->toImage(size);
+        QVERIFY(img3.cacheKey() != img.cacheKey());
+
+        // as do data changes
+        code->setData(QStringLiteral("KDE"));
+        QVERIFY(code->toImage(size).cacheKey() != img3.cacheKey());
+    }
+};
+
+QTEST_APPLESS_MAIN(BarcodeMatrixTest)
+
+#include "barcodematrixtest.moc"
@@ -0,0 +1,278 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: MIT
+*/
+
+#include "../src/lib/bitvector_p.h"
+
+#include <QObject>
+#include <QTest>
+
+Q_DECLARE_METATYPE(Prison::BitVector)
+
+using namespace Prison;
+
+class BitVectorTest : public QObject
+{
+    Q_OBJECT
+private:
+    // bit by bit reference implementations, for comparison in the benchmarks
+    static void appendMSBBitwise(BitVector &v, quint64 data, int bits)
+    {
+        for (int i = bits - 1; i >= 0; --i) {
+            v.appendBit(data & (quint64(1) << i));
+        }
+    }
+    static quint64 valueAtMSBBitwise(const BitVector &v, int index, int size)
+    {
+        quint64 res = 0;
+        for (int i = 0; i < size; ++i) {
+            res = (res << 1) | (v.at(index + i) ? 1 : 0);
+        }
+        return res;
+    }
+
+private Q_SLOTS:
+    void testAppend()
+    {
+        BitVector v;
+        v.appendMSB(0b101, 3);
+        v.appendLSB(0b011, 3);
+        v.appendBit(true);
+        QCOMPARE(v.size(), 7);
+        QCOMPARE(v.valueAtMSB(0, 7), 0b1011101);
+
+        // crossing word boundaries
+        v.appendMSB(0xfedcba9876543210ull, 64);
+        QCOMPARE(v.size(), 71);
+        QCOMPARE(v.valueAtMSB64(7, 64), 0xfedcba9876543210ull);
+        QCOMPARE(v.valueAtMSB(7, 4), 0xf);
+        QCOMPARE(v.valueAtMSB(67, 4), 0);
+        v.appendLSB(0x1, 60);
+        QCOMPARE(v.size(), 131);
+        QCOMPARE(v.valueAtMSB64(71, 60), 1ull << 59);
+        QCOMPARE(v.at(71), true);
+        QCOMPARE(v.at(72), false);
+
+        // only the lowest bits are used
+        BitVector w;
+        w.appendMSB(-1, 5);
+        QCOMPARE(w.size(), 5);
+        QCOMPARE(w.valueAtMSB(0, 5), 0x1f);
+        w.appendMSB(0, 0);
+        QCOMPARE(w.size(), 5);
+
+        // merging, aligned and unaligned
+        BitVector a;
+        a.append(v);
+        QCOMPARE(a, v);
+        a.append(w);
+        QCOMPARE(a.size(), 136);
+        QCOMPARE(a.valueAtMSB64(0, 64), v.valueAtMSB64(0, 64));
+        QCOMPARE(a.valueAtMSB(131, 5), 0x1f);
+        BitVector b;
+        b.append(w);
+        b.append(v);
+        QCOMPARE(b.size(), 136);
+        for (int i = 0; i < v.size(); ++i) {
+            QCOMPARE(b.at(i + 5), v.at(i));
+        }
+
+        int count = 0;
+        for (const auto bit : b) {
+            QCOMPARE(bit, b.at(count++));
+        }
+        QCOMPARE(count, b.size());
+    }
+
+    void testCompare()
+    {
+        BitVector v1;
+        BitVector v2;
+        QCOMPARE(v1, v2);
+        v1.appendBit(false);
+        QVERIFY(v1 != v2);
+        v2.appendMSB(0, 1);
+        QCOMPARE(v1, v2);
+        v1.appendMSB(0x55, 70 - 64);
+        v2.appendLSB(0b101010, 6);
+        QCOMPARE(v1, v2);
+        v1.clear();
+        QCOMPARE(v1.size(), 0);
+        QCOMPARE(v1, BitVector());
+    }
+
+    void testInlineStorage()
+    {
+        // grow across the inline storage limit, and copy in both states
+        BitVector v;
+        for (int i = 0; i < BitVector::InlineBits / 8; ++i) {
+            v.appendMSB(i, 8);
+        }
+        QCOMPARE(v.size(), BitVector::InlineBits);
+        BitVector small = v;
+        QCOMPARE(small, v);
+        v.appendMSB(0xabc, 12);
+        QVERIFY(small != v);
+        QCOMPARE(small.size(), BitVector::InlineBits);
+
+        BitVector large = v;
+        QCOMPARE(large, v);
+        QCOMPARE(large.valueAtMSB(BitVector::InlineBits, 12), 0xabc);
+        for (int i = 0; i < BitVector::InlineBits / 8; ++i) {
+            QCOMPARE(large.valueAtMSB(i * 8, 8), i);
+        }
+        large = small;
+        QCOMPARE(large, small);
+        large.clear();
+        QCOMPARE(large.size(), 0);
+        large.appendBit(true);
+        QCOMPARE(large.valueAtMSB(0, 1), 1);
+    }
+
+    void testReader()
+    {
+        BitVector v;
+        v.appendMSB(0b1101, 4);
+        v.appendMSB(0xfedcba9876543210ull, 64);
+        v.appendMSB(0x2a, 6);
+        QCOMPARE(v.size(), 74);
+
+        auto reader = BitVectorView(v).reader();
+        QCOMPARE(reader.remaining(), 74);
+        QCOMPARE(reader.readBit(), true);
+        QCOMPARE(reader.read(3), 0b101ull);
+        QCOMPARE(reader.read(0), 0ull);
+        QCOMPARE(reader.read(64), 0xfedcba9876543210ull);
+        QCOMPARE(reader.remaining(), 6);
+        QVERIFY(!reader.atEnd());
+        QCOMPARE(reader.read(6), 0x2aull);
+        QVERIFY(reader.atEnd());
+
+        // odd widths crossing the internal buffer boundary
+        reader = BitVectorView(v).reader();
+        int pos = 0;
+        while (reader.remaining() >= 7) {
+            QCOMPARE(reader.read(7), v.valueAtMSB64(pos, 7));
+            pos += 7;
+        }
+        QCOMPARE(reader.read(reader.remaining()), v.valueAtMSB64(pos, v.size() - pos));
+
+        // sub-views
+        const BitVectorView view(v, 4, 64);
+        QCOMPARE(view.size(), 64);
+        QCOMPARE(view.at(0), true);
+        QCOMPARE(view.valueAtMSB64(0, 64), 0xfedcba9876543210ull);
+        const auto mid = view.mid(60, 8);
+        QCOMPARE(mid.size(), 8);
+        QCOMPARE(mid.valueAtMSB64(0, 8), 0x0aull);
+        reader = mid.reader();
+        QCOMPARE(reader.read(4), 0x0ull);
+        QCOMPARE(reader.read(4), 0xaull);
+        QVERIFY(reader.atEnd());
+        QVERIFY(BitVectorView(v, 74, 0).reader().atEnd());
+    }
+
+    void benchmarkAppendMSB_data()
+    {
+        QTest::addColumn<bool>("bitwise");
+        QTest::newRow("bitwise") << true;
+        QTest::newRow("word") << false;
+    }
+
+    void benchmarkAppendMSB()
+    {
+        QFETCH(bool, bitwise);
+        QBENCHMARK {
+            BitVector v;
+            for (int i = 0; i < 10000; ++i) {
+                if (bitwise) {
+                    appendMSBBitwise(v, i, 10);
+                } else {
+                    v.appendMSB(i, 10);
+                }
+            }
+        }
+    }
+
+    void benchmarkValueAtMSB_data()
+    {
+        benchmarkAppendMSB_data();
+    }
+
+    void benchmarkValueAtMSB()
+    {
+        QFETCH(bool, bitwise);
+        BitVector v;
+        for (int i = 0; i < 10000; ++i) {
+            v.appendMSB(i, 12);
+        }
+        quint64 sum = 0;
+        QBENCHMARK {
+            for (int i = 0; i < 10000; ++i) {
+                sum += bitwise ? valueAtMSBBitwise(v, i * 12, 12) : v.valueAtMSB(i * 12, 12);
+            }
+        }
+        QVERIFY(sum > 0);
+    }
+
+    void benchmarkReader_data()
+    {
+        QTest::addColumn<bool>("reader");
+        QTest::newRow("valueAtMSB") << false;
+        QTest::newRow("reader") << true;
+    }
+
+    void benchmarkReader()
+    {
+        QFETCH(bool, reader);
+        BitVector v;
+        for (int i = 0; i < 10000; ++i) {
+            v.appendMSB(i, 12);
+        }
+        quint64 sum = 0;
+        QBENCHMARK {
+            if (reader) {
+                auto r = BitVectorView(v).reader();
+                while (!r.atEnd()) {
+                    sum += r.read(12);
+                }
+            } else {
+                for (int i = 0; i < 10000; ++i) {
+                    sum += v.valueAtMSB(i * 12, 12);
+                }
+            }
+        }
+        QVERIFY(sum > 0);
+    }
+
+    void benchmarkAppend_data()
+    {
+        benchmarkAppendMSB_data();
+    }
+
+    void benchmarkAppend()
+    {
+        QFETCH(bool, bitwise);
+        BitVector v;
+        for (int i = 0; i < 10000; ++i) {
+            v.appendMSB(i, 12);
+        }
+        QBENCHMARK {
+            BitVector w;
+            w.appendBit(true);
+            if (bitwise) {
+                for (const auto bit : v) {
+                    w.appendBit(bit);
+                }
+            } else {
+                w.append(v);
+            }
+        }
+    }
+};
+
+QTEST_APPLESS_MAIN(BitVectorTest)
+
+#include "bitvectortest.moc"
@@ -219,7 +219,7 @@ private Q_SLOTS:
         {
             Code128Barcode code;
             code.setData(QString::fromLatin1(input.constData(), input.size()));
-            const auto img = code.paintImage({});
+            const auto img = code.toImage(code.trueMinimumSize());
             img.save(refName);
 
             QImage ref(QStringLiteral(":/code128/") + refName);
@@ -230,7 +230,7 @@ private Q_SLOTS:
         {
             Code128Barcode code;
             code.setData(input);
-            const auto img = code.paintImage({});
+            const auto img = code.toImage(code.trueMinimumSize());
             img.save(refName);
 
             QImage ref(QStringLiteral(":/code128/") + refName);
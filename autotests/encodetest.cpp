@@ -0,0 +1,272 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: MIT
+*/
+
+#include <prison.h>
+
+#include <QObject>
+#include <QThread>
+#include <QTest>
+#include <QThreadPool>
+#include <QVector>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+using namespace Prison;
+
+Q_DECLARE_METATYPE(Prison::BarcodeType)
+
+class EncodeTest : public QObject
+{
+    Q_OBJECT
+private:
+    static QString payload(int i)
+    {
+        return QLatin1String("PRISON-") + QString::number(i * 7919);
+    }
+
+private Q_SLOTS:
+    void testEncode_data()
+    {
+        QTest::addColumn<Prison::BarcodeType>("type");
+        QTest::newRow("QRCode") << QRCode;
+        QTest::newRow("DataMatrix") << DataMatrix;
+        QTest::newRow("Aztec") << Aztec;
+        QTest::newRow("Code39") << Code39;
+        QTest::newRow("Code93") << Code93;
+        QTest::newRow("Code128") << Code128;
+        QTest::newRow("PDF417") << PDF417;
+    }
+
+    void testEncode()
+    {
+        QFETCH(Prison::BarcodeType, type);
+        std::unique_ptr<AbstractBarcode> code(createBarcode(type));
+        if (!code) {
+            QVERIFY(encode(type, QStringLiteral("KDE")).isNull());
+            return;
+        }
+
+        code->setData(QStringLiteral("KDE"));
+        QCOMPARE(encode(type, QStringLiteral("KDE")), code->matrix());
+        code->setData(QByteArray("KDE"));
+        QCOMPARE(encode(type, QByteArray("KDE")), code->matrix());
+
+        QVERIFY(encode(type, QString()).isNull());
+        QVERIFY(encode(Null, QStringLiteral("KDE")).isNull());
+    }
+
+    void testConcurrentEncode_data()
+    {
+        testEncode_data();
+    }
+
+    void testConcurrentEncode()
+    {
+        QFETCH(Prison::BarcodeType, type);
+        if (encode(type, QStringLiteral("KDE")).isNull()) {
+            QSKIP("barcode type not supported in this build");
+        }
+
+        constexpr int Count = 200;
+        QVector<BarcodeMatrix> expected(Count);
+        for (int i = 0; i < Count; ++i) {
+            expected[i] = encode(type, payload(i));
+            QVERIFY(!expected[i].isNull());
+        }
+
+        QVector<BarcodeMatrix> results(Count);
+        auto resultData = results.data();
+        QThreadPool pool;
+        pool.setMaxThreadCount(std::max(4, QThread::idealThreadCount()));
+        for (int i = 0; i < Count; ++i) {
+            pool.start([type, i, resultData]() {
+                resultData[i] = encode(type, payload(i));
+            });
+        }
+        pool.waitForDone();
+
+        for (int i = 0; i < Count; ++i) {
+            QCOMPARE(results[i], expected[i]);
+        }
+    }
+
+    void testSymbolInfo_data()
+    {
+        testEncode_data();
+    }
+
+    void testSymbolInfo()
+    {
+        QFETCH(Prison::BarcodeType, type);
+        if (encode(type, QStringLiteral("KDE")).isNull()) {
+            QVERIFY(!symbolInfo(type, QStringLiteral("KDE")).fits);
+            QSKIP("barcode type not supported in this build");
+        }
+
+        // the cheap geometry pre-flight has to match the actual encoding result
+        const QString payloads[] = {QStringLiteral("KDE"),
+                                    QStringLiteral("0123456789"),
+                                    QStringLiteral("Hello World! This is a slightly longer text, with some punctuation."),
+                                    QString(500, QLatin1Char('X')),
+                                    QString(1500, QLatin1Char('7')),
+                                    QString(8000, QLatin1Char('x'))};
+        for (const auto &payload : payloads) {
+            const auto matrix = encode(type, payload);
+            const auto info = symbolInfo(type, payload);
+            QCOMPARE(info.fits, !matrix.isNull());
+            QCOMPARE(info.size, matrix.size());
+
+            const auto binaryMatrix = encode(type, payload.toLatin1());
+            const auto binaryInfo = symbolInfo(type, payload.toLatin1());
+            QCOMPARE(binaryInfo.fits, !binaryMatrix.isNull());
+            QCOMPARE(binaryInfo.size, binaryMatrix.size());
+
+            std::unique_ptr<AbstractBarcode> code(createBarcode(type));
+            code->setData(payload);
+            QCOMPARE(code->trueMinimumSize(), QSizeF(matrix.size()));
+        }
+
+        const auto emptyInfo = symbolInfo(type, QString());
+        QVERIFY(!emptyInfo.fits);
+        QVERIFY(emptyInfo.size.isEmpty());
+    }
+
+    void testSymbolInfoVersion()
+    {
+        auto info = symbolInfo(QRCode, QStringLiteral("KDE"));
+        QVERIFY(info.fits);
+        QCOMPARE(info.version, 1);
+        QCOMPARE(info.size, QSize(29, 29));
+        info = symbolInfo(QRCode, QString(200, QLatin1Char('x')));
+        QVERIFY(info.fits);
+        QCOMPARE(info.size.width(), 17 + 4 * info.version + 8);
+        QVERIFY(!symbolInfo(QRCode, QString(8000, QLatin1Char('x'))).fits);
+
+        // sizing and rendering the same instance shares one encoding, also without the symbol cache
+        std::unique_ptr<AbstractBarcode> code(createBarcode(QRCode));
+        code->setData(QStringLiteral("KDE"));
+        QCOMPARE(code->trueMinimumSize(), QSizeF(29, 29));
+        const auto m = code->matrix();
+        QVERIFY(code->matrix().constScanLine(0) == m.constScanLine(0));
+        QCOMPARE(m, encode(QRCode, QStringLiteral("KDE")));
+
+        info = symbolInfo(Aztec, QStringLiteral("KDE"));
+        QVERIFY(info.fits);
+        QVERIFY(info.compact);
+        QCOMPARE(info.version, 1);
+        QCOMPARE(info.size, QSize(15, 15));
+        info = symbolInfo(Aztec, QString(500, QLatin1Char('X')));
+        QVERIFY(info.fits);
+        QVERIFY(!info.compact);
+        QVERIFY(info.version > 4);
+        QVERIFY(!symbolInfo(Aztec, QString(8000, QLatin1Char('x'))).fits);
+
+        info = symbolInfo(Code128, QStringLiteral("KDE"));
+        QVERIFY(info.fits);
+        QCOMPARE(info.version, 0);
+        QCOMPARE(info.size.height(), 1);
+    }
+
+    void testEncodeBatch_data()
+    {
+        testEncode_data();
+    }
+
+    void testEncodeBatch()
+    {
+        QFETCH(Prison::BarcodeType, type);
+        if (encode(type, QStringLiteral("KDE")).isNull()) {
+            const auto results = encodeBatch(type, QStringList{QStringLiteral("KDE")});
+            QCOMPARE(results.size(), 1);
+            QVERIFY(results[0].isNull());
+            QSKIP("barcode type not supported in this build");
+        }
+
+        constexpr int Count = 1000;
+        QStringList data;
+        QByteArrayList byteData;
+        for (int i = 0; i < Count; ++i) {
+            data.push_back(payload(i));
+            byteData.push_back(payload(i).toLatin1());
+        }
+        data[10] = QString(); // not encodable, must not disturb the ordering
+
+        // batches bypass the symbol cache, even when enabled
+        setSymbolCacheBudget(1024 * 1024);
+        clearSymbolCache();
+        const auto results = encodeBatch(type, data);
+        setSymbolCacheBudget(0);
+        QCOMPARE(results.size(), Count);
+        QCOMPARE(symbolCacheStatistics().count, 0);
+        QCOMPARE(symbolCacheStatistics().misses, quint64(0));
+        for (int i = 0; i < Count; ++i) {
+            QCOMPARE(results[i], encode(type, data[i]));
+        }
+        QVERIFY(results[10].isNull());
+
+        const auto byteResults = encodeBatch(type, byteData);
+        QCOMPARE(byteResults.size(), Count);
+        for (int i = 0; i < Count; ++i) {
+            QCOMPARE(byteResults[i], encode(type, byteData[i]));
+        }
+
+        QVector<BarcodeMatrix> streamed(Count);
+        auto streamedData = streamed.data();
+        std::atomic<int> callCount(0);
+        encodeBatch(type, data, [&callCount, streamedData](int index, const BarcodeMatrix &matrix) {
+            streamedData[index] = matrix;
+            ++callCount;
+        });
+        QCOMPARE(callCount.load(), Count);
+        QCOMPARE(streamed, results);
+
+        QVERIFY(encodeBatch(type, QStringList()).isEmpty());
+    }
+
+    void testAztecOptions()
+    {
+        AztecOptions options;
+        options.minimumLayerCount = 3;
+        const auto data = QStringLiteral("KF5::Prison");
+
+        // a compact code with 3 layers instead of 1
+        const auto info = symbolInfo(Aztec, data, options);
+        QVERIFY(info.fits);
+        QCOMPARE(info.version, 3);
+        QVERIFY(info.compact);
+        QCOMPARE(info.size, QSize(23, 23));
+        QCOMPARE(symbolInfo(Aztec, data).size, QSize(15, 15));
+
+        const auto m = encode(Aztec, data, options);
+        QCOMPARE(m.size(), info.size);
+        QCOMPARE(encode(Aztec, data.toLatin1(), options).size(), info.size);
+        QCOMPARE(encode(Aztec, data).size(), QSize(15, 15));
+
+        const auto results = encodeBatch(Aztec, QStringList{data, QStringLiteral("KDE")}, options);
+        QCOMPARE(results.size(), 2);
+        QCOMPARE(results[0], m);
+        QCOMPARE(results[1].size(), info.size);
+        std::atomic<int> callCount(0);
+        encodeBatch(
+            Aztec,
+            QByteArrayList{data.toLatin1()},
+            [&callCount, m](int, const BarcodeMatrix &matrix) {
+                QCOMPARE(matrix, m);
+                ++callCount;
+            },
+            options);
+        QCOMPARE(callCount.load(), 1);
+
+        // other barcode types ignore them
+        QCOMPARE(encode(QRCode, data, options), encode(QRCode, data));
+    }
+};
+
+QTEST_GUILESS_MAIN(EncodeTest)
+
+#include "encodetest.moc"
@@ -5,11 +5,13 @@
 */
 
 #include "../src/lib/bitvector_p.h"
+#include "../src/lib/galoisfield_p.h"
 #include "../src/lib/reedsolomon_p.h"
 
 #include <QDebug>
 #include <QObject>
 #include <QTest>
+#include <QVector>
 
 Q_DECLARE_METATYPE(Prison::BitVector)
 
@@ -18,7 +20,37 @@ using namespace Prison;
 class ReedSolomonTest : public QObject
 {
     Q_OBJECT
+private:
+    template<int Polynom>
+    static void checkField()
+    {
+        using Field = GaloisField<Polynom>;
+        for (int a = 1; a < Field::Size; ++a) {
+            QCOMPARE(int(Field::exp(Field::log(a))), a);
+            QCOMPARE(int(Field::mul(Field::div(1, a), a)), 1);
+            QCOMPARE(int(Field::mul(a, 0)), 0);
+            QCOMPARE(int(Field::mulExp(a, 1)), int(Field::mul(a, 2)));
+        }
+        QCOMPARE(int(Field::exp(Field::LogMod)), 1);
+    }
+
 private Q_SLOTS:
+    void testGaloisField()
+    {
+        static_assert(GaloisField<ReedSolomon::GF16>::SymbolSize == 4);
+        static_assert(GaloisField<ReedSolomon::GF4096>::Size == 4096);
+        static_assert(sizeof(GaloisField<ReedSolomon::GF256>::Symbol) == 1);
+        static_assert(sizeof(GaloisField<ReedSolomon::GF1024>::Symbol) == 2);
+        static_assert(GaloisField<ReedSolomon::GF256>::mul(0x80, 2) == (0x100 ^ ReedSolomon::GF256));
+        static_assert(GaloisField<ReedSolomon::GF16>::exp(4) == (0x10 ^ ReedSolomon::GF16));
+
+        checkField<ReedSolomon::GF16>();
+        checkField<ReedSolomon::GF64>();
+        checkField<ReedSolomon::GF256>();
+        checkField<ReedSolomon::GF1024>();
+        checkField<ReedSolomon::GF4096>();
+    }
+
     void rsTest_data()
     {
         QTest::addColumn<int>("poly");
@@ -38,6 +70,23 @@ private Q_SLOTS:
         out.appendMSB(5, 7);
         out.appendMSB(0x4d, 7);
         QTest::newRow("GF16") << (int)ReedSolomon::GF16 << 5 << in << out;
+
+        // input symbols i * 37 + 1, for each field size
+        const auto addRow = [](const char *name, ReedSolomon::GF gf, int symSize, int inputCount, std::initializer_list<int> ecc) {
+            BitVector in;
+            for (int i = 0; i < inputCount; ++i) {
+                in.appendMSB(i * 37 + 1, symSize);
+            }
+            BitVector out;
+            for (const auto sym : ecc) {
+                out.appendMSB(sym, symSize);
+            }
+            QTest::newRow(name) << (int)gf << (int)ecc.size() << in << out;
+        };
+        addRow("GF64", ReedSolomon::GF64, 6, 5, {0x25, 0x37, 0x19, 0x38});
+        addRow("GF256", ReedSolomon::GF256, 8, 6, {0xa2, 0x1f, 0xfd, 0x16});
+        addRow("GF1024", ReedSolomon::GF1024, 10, 4, {0x2de, 0x356, 0x27f});
+        addRow("GF4096", ReedSolomon::GF4096, 12, 4, {0xb62, 0xeed, 0x359});
     }
 
     void rsTest()
@@ -55,6 +104,100 @@ private Q_SLOTS:
             qDebug() << "Expected:" << output;
         }
         QCOMPARE(res, output);
+
+        // a second instance uses the shared tables and generator polynom
+        ReedSolomon rs2(poly, symCount);
+        QCOMPARE(rs2.encode(input), output);
+
+        // same via the code word array API
+        QVector<quint16> data;
+        for (int i = 0; i < input.size() / rs.symbolSize(); ++i) {
+            data.push_back(input.valueAtMSB(i * rs.symbolSize(), rs.symbolSize()));
+        }
+        QVector<quint16> ecc(symCount);
+        rs.encode(data.constData(), data.size(), ecc.data());
+        for (int i = 0; i < symCount; ++i) {
+            QCOMPARE(int(ecc[i]), output.valueAtMSB(i * rs.symbolSize(), rs.symbolSize()));
+        }
+    }
+
+    void testDecode_data()
+    {
+        testInterleaved_data();
+    }
+
+    void testDecode()
+    {
+        QFETCH(int, poly);
+        QFETCH(int, symCount);
+
+        ReedSolomon rs(poly, symCount);
+        const auto mask = (1 << rs.symbolSize()) - 1;
+        const auto dataCount = std::min(11, mask - symCount); // code words are limited to the field size
+        QVector<quint16> codewords(dataCount + symCount);
+        for (int i = 0; i < dataCount; ++i) {
+            codewords[i] = (i * 97 + 13) & mask;
+        }
+        rs.encode(codewords.constData(), dataCount, codewords.data() + dataCount);
+        const auto reference = codewords;
+        QCOMPARE(rs.decode(codewords.data(), codewords.size()), 0);
+        QCOMPARE(codewords, reference);
+
+        // up to symCount / 2 errors, in data and error correction code words
+        for (int errors = 1; errors <= symCount / 2; ++errors) {
+            codewords = reference;
+            for (int i = 0; i < errors; ++i) {
+                const auto pos = (i * 7) % codewords.size();
+                codewords[pos] ^= ((i * 31 + 5) & mask) | 1;
+            }
+            QCOMPARE(rs.decode(codewords.data(), codewords.size()), errors);
+            QCOMPARE(codewords, reference);
+        }
+
+        // too many errors
+        codewords = reference;
+        for (int i = 0; i <= symCount / 2; ++i) {
+            codewords[i * 2] ^= ((i * 31 + 5) & mask) | 1;
+        }
+        QCOMPARE(rs.decode(codewords.data(), codewords.size()), -1);
+    }
+
+    void testInterleaved_data()
+    {
+        QTest::addColumn<int>("poly");
+        QTest::addColumn<int>("symCount");
+        QTest::newRow("GF16") << (int)ReedSolomon::GF16 << 6;
+        QTest::newRow("GF256") << (int)ReedSolomon::GF256 << 22;
+        QTest::newRow("GF4096") << (int)ReedSolomon::GF4096 << 30;
+    }
+
+    void testInterleaved()
+    {
+        QFETCH(int, poly);
+        QFETCH(int, symCount);
+
+        ReedSolomon rs(poly, symCount);
+        const int blockCount = 3;
+        const int dataCount = 11;
+        QVector<quint16> data(dataCount * blockCount);
+        for (int i = 0; i < data.size(); ++i) {
+            data[i] = (i * 97 + 13) & ((1 << rs.symbolSize()) - 1);
+        }
+
+        QVector<quint16> ecc(symCount * blockCount);
+        rs.encodeInterleaved(data.constData(), dataCount, blockCount, ecc.data());
+
+        for (int b = 0; b < blockCount; ++b) {
+            QVector<quint16> block;
+            for (int i = 0; i < dataCount; ++i) {
+                block.push_back(data[i * blockCount + b]);
+            }
+            QVector<quint16> blockEcc(symCount);
+            rs.encode(block.constData(), dataCount, blockEcc.data());
+            for (int k = 0; k < symCount; ++k) {
+                QCOMPARE(ecc[k * blockCount + b], blockEcc[k]);
+            }
+        }
     }
 };
 
@@ -0,0 +1,140 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: MIT
+*/
+
+#include <prison.h>
+
+#include <QObject>
+#include <QTest>
+
+#include <memory>
+
+using namespace Prison;
+
+class SymbolCacheTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // opt-in only
+        QCOMPARE(symbolCacheBudget(), qint64(0));
+        QVERIFY(!encode(QRCode, QStringLiteral("KDE")).isNull());
+        QCOMPARE(symbolCacheStatistics().misses, quint64(0));
+        QCOMPARE(symbolCacheStatistics().count, 0);
+    }
+
+    void init()
+    {
+        setSymbolCacheBudget(1024 * 1024);
+        clearSymbolCache();
+    }
+
+    void testSharing()
+    {
+        std::unique_ptr<AbstractBarcode> code1(createBarcode(QRCode));
+        code1->setData(QStringLiteral("KF5::Prison"));
+        const auto m1 = code1->matrix();
+        QVERIFY(!m1.isNull());
+        QCOMPARE(symbolCacheStatistics().misses, quint64(1));
+        QCOMPARE(symbolCacheStatistics().hits, quint64(0));
+        QCOMPARE(symbolCacheStatistics().count, 1);
+        QVERIFY(symbolCacheStatistics().cost > 0);
+
+        // same content in another instance is not encoded again, and shares the matrix
+        std::unique_ptr<AbstractBarcode> code2(createBarcode(QRCode));
+        code2->setData(QStringLiteral("KF5::Prison"));
+        QVERIFY(code2->matrix().constScanLine(0) == m1.constScanLine(0));
+        QCOMPARE(symbolCacheStatistics().hits, quint64(1));
+        QVERIFY(encode(QRCode, QStringLiteral("KF5::Prison")).constScanLine(0) == m1.constScanLine(0));
+        QCOMPARE(symbolCacheStatistics().hits, quint64(2));
+        QCOMPARE(symbolCacheStatistics().misses, quint64(1));
+
+        // different type, or textual vs. binary content are different entries
+        QVERIFY(!encode(Aztec, QStringLiteral("KF5::Prison")).isNull());
+        QVERIFY(!encode(QRCode, QByteArray("KF5::Prison")).isNull());
+        QCOMPARE(symbolCacheStatistics().misses, quint64(3));
+        QCOMPARE(symbolCacheStatistics().count, 3);
+
+        // so is content encoded with different parameters
+        std::unique_ptr<AbstractBarcode> code3(createBarcode(Aztec));
+        code3->setData(QStringLiteral("KF5::Prison"));
+        AztecOptions options;
+        options.minimumLayerCount = 3;
+        code3->setAztecOptions(options);
+        const auto m3 = code3->matrix();
+        QCOMPARE(symbolCacheStatistics().misses, quint64(4));
+        QVERIFY(m3.size() != encode(Aztec, QStringLiteral("KF5::Prison")).size());
+        QCOMPARE(symbolCacheStatistics().hits, quint64(3));
+        code3->setAztecOptions({});
+        QVERIFY(code3->matrix().size() != m3.size());
+        QCOMPARE(symbolCacheStatistics().hits, quint64(4));
+        QCOMPARE(symbolCacheStatistics().count, 4);
+
+        clearSymbolCache();
+        QCOMPARE(symbolCacheStatistics().count, 0);
+        QCOMPARE(symbolCacheStatistics().cost, qint64(0));
+        QCOMPARE(symbolCacheStatistics().hits, quint64(0));
+        QCOMPARE(symbolCacheStatistics().misses, quint64(0));
+    }
+
+    void testBudget()
+    {
+        QVERIFY(!encode(QRCode, QStringLiteral("KDE-1")).isNull());
+        const auto entryCost = symbolCacheStatistics().cost;
+        QVERIFY(entryCost > 0);
+
+        // room for two entries of the same size
+        setSymbolCacheBudget(entryCost * 2);
+        QCOMPARE(symbolCacheBudget(), entryCost * 2);
+        QVERIFY(!encode(QRCode, QStringLiteral("KDE-2")).isNull());
+        QCOMPARE(symbolCacheStatistics().count, 2);
+        QVERIFY(!encode(QRCode, QStringLiteral("KDE-1")).isNull()); // hit, making KDE-2 the least recently used
+        QCOMPARE(symbolCacheStatistics().hits, quint64(1));
+        QVERIFY(!encode(QRCode, QStringLiteral("KDE-3")).isNull());
+        QCOMPARE(symbolCacheStatistics().count, 2);
+        QVERIFY(symbolCacheStatistics().cost <= entryCost * 2);
+
+        clearSymbolCache();
+        setSymbolCacheBudget(entryCost * 2);
+        QVERIFY(!encode(QRCode, QStringLiteral("KDE-1")).isNull());
+        QVERIFY(!encode(QRCode, QStringLiteral("KDE-2")).isNull());
+        QVERIFY(!encode(QRCode, QStringLiteral("KDE-1")).isNull());
+        QVERIFY(!encode(QRCode, QStringLiteral("KDE-3")).isNull());
+        QVERIFY(!encode(QRCode, QStringLiteral("KDE-1")).isNull());
+        QCOMPARE(symbolCacheStatistics().hits, quint64(2));
+        QVERIFY(!encode(QRCode, QStringLiteral("KDE-2")).isNull());
+        QCOMPARE(symbolCacheStatistics().hits, quint64(2)); // evicted
+
+        // entries larger than the budget are not cached
+        clearSymbolCache();
+        setSymbolCacheBudget(entryCost - 1);
+        QVERIFY(!encode(QRCode, QStringLiteral("KDE-1")).isNull());
+        QCOMPARE(symbolCacheStatistics().count, 0);
+    }
+
+    void testDisabled()
+    {
+        setSymbolCacheBudget(0);
+        QCOMPARE(symbolCacheBudget(), qint64(0));
+        const auto m1 = encode(QRCode, QStringLiteral("KDE"));
+        const auto m2 = encode(QRCode, QStringLiteral("KDE"));
+        QVERIFY(!m1.isNull());
+        QCOMPARE(m1, m2);
+        QVERIFY(m1.constScanLine(0) != m2.constScanLine(0));
+        QCOMPARE(symbolCacheStatistics().hits, quint64(0));
+        QCOMPARE(symbolCacheStatistics().misses, quint64(0));
+        QCOMPARE(symbolCacheStatistics().count, 0);
+    }
+
+    void cleanupTestCase()
+    {
+        setSymbolCacheBudget(0);
+    }
+};
+
+QTEST_APPLESS_MAIN(SymbolCacheTest)
+
+#include "symbolcachetest.moc"
@@ -5,60 +5,194 @@
 */
 
 #include "abstractbarcode.h"
+#include "abstractbarcode_p.h"
+#include "aztecbarcode.h"
+#include "barcodematrix_p.h"
+#include "code128barcode.h"
+#include "code39barcode.h"
+#include "code93barcode.h"
 #include "config-prison.h"
 #include "pdf417barcode.h"
+#include "qrcodebarcode.h"
+#include "rasterizer_p.h"
+#include "symbolcache_p.h"
+#include "vectorizer_p.h"
 
-#include <QColor>
 #include <QPainter>
-#include <QVariant>
+
+#include <algorithm>
 
 using namespace Prison;
-/**
- * @cond private
- */
-class Prison::AbstractBarcodePrivate
-{
-public:
-    QVariant m_data;
-    QImage m_cache;
-    QColor m_foreground = Qt::black;
-    QColor m_background = Qt::white;
-    AbstractBarcode::Dimensions m_dimension = AbstractBarcode::NoDimensions;
-    AbstractBarcode *q;
-
-    bool sizeTooSmall(const QSizeF &size) const
-    {
-        return m_cache.width() > size.width() || m_cache.height() > size.height();
-    }
-
-    bool isEmpty() const
-    {
-        switch (m_data.type()) {
-        case QVariant::String:
-            return m_data.toString().isEmpty();
-        case QVariant::ByteArray:
-            return m_data.toByteArray().isEmpty();
-        default:
-            break;
+
+AbstractBarcodePrivate::AbstractBarcodePrivate(AbstractBarcode *barcode)
+    : q(barcode)
+{
+}
+
+bool AbstractBarcodePrivate::sizeTooSmall(const QSizeF &size) const
+{
+    return m_matrix.width() > size.width() || m_matrix.height() > size.height();
+}
+
+// scale to the requested size, using only full integer factors to keep the code readable
+void AbstractBarcodePrivate::scaleFor(const QSizeF &size, int *scaleX, int *scaleY) const
+{
+    *scaleX = std::max<int>(1, size.width() / m_matrix.width());
+    *scaleY = std::max<int>(1, size.height() / m_matrix.height());
+    if (m_dimension == AbstractBarcode::TwoDimensions) {
+        *scaleX = *scaleY = std::min(*scaleX, *scaleY);
+    }
+}
+
+bool AbstractBarcodePrivate::isEmpty() const
+{
+    switch (m_data.type()) {
+    case QVariant::String:
+        return m_data.toString().isEmpty();
+    case QVariant::ByteArray:
+        return m_data.toByteArray().isEmpty();
+    default:
+        break;
+    }
+    return true;
+}
+
+QByteArray AbstractBarcodePrivate::encodingParameters() const
+{
+    QByteArray params;
+    if (m_type == Aztec && m_aztecOptions != AztecOptions()) {
+        const auto &o = m_aztecOptions;
+        for (const auto value : {o.errorCorrectionPercent, int(o.format), o.minimumLayerCount, o.maximumLayerCount}) {
+            params.append(reinterpret_cast<const char *>(&value), sizeof(value));
+        }
+    }
+    return params;
+}
+
+void AbstractBarcodePrivate::recompute()
+{
+    if (!m_matrix.isNull() || isEmpty()) {
+        return;
+    }
+
+    // identical content encodes to the identical matrix, so built-in generators can share it
+    QByteArray cacheKey;
+    if (m_type != Null && SymbolCache::isEnabled()) {
+        cacheKey = SymbolCache::key(m_type, m_data, encodingParameters());
+        m_matrix = SymbolCache::find(cacheKey);
+        if (!m_matrix.isNull()) {
+            return;
         }
-        return true;
     }
 
-    void recompute()
-    {
-        if (m_cache.isNull() && !isEmpty()) {
-            m_cache = q->paintImage({});
+    m_matrix = encode();
+    if (!cacheKey.isEmpty() && !m_matrix.isNull()) {
+        SymbolCache::insert(cacheKey, m_matrix);
+    }
+}
+
+BarcodeMatrix AbstractBarcodePrivate::encode()
+{
+    if (isEmpty()) {
+        return {};
+    }
+
+    const auto img = q->paintImage({});
+    m_matrixDependsOnColors = img.format() != QImage::Format_Mono;
+    if (m_matrixDependsOnColors) {
+        return BarcodeMatrixPrivate::fromModuleImage(BarcodeMatrixPrivate::toModuleImage(img, m_background.rgba()));
+    }
+    return BarcodeMatrixPrivate::fromModuleImage(img);
+}
+
+SymbolInfo AbstractBarcodePrivate::symbolInfo()
+{
+    if (isEmpty()) {
+        return {};
+    }
+
+    switch (m_type) {
+    case Prison::QRCode:
+        return static_cast<QRCodeBarcode *>(q)->symbolInfo();
+    case Prison::Aztec:
+        return static_cast<AztecBarcode *>(q)->symbolInfo();
+    case Prison::Code39:
+        return static_cast<Code39Barcode *>(q)->symbolInfo();
+    case Prison::Code93:
+        return static_cast<Code93Barcode *>(q)->symbolInfo();
+    case Prison::Code128:
+        return static_cast<Code128Barcode *>(q)->symbolInfo();
+    default:
+        break;
+    }
+
+    // no cheaper way than to fully encode
+    recompute();
+    SymbolInfo info;
+    info.fits = !m_matrix.isNull();
+    info.size = m_matrix.size();
+    return info;
+}
+
+QSize AbstractBarcodePrivate::symbolSize()
+{
+    if (!m_matrix.isNull()) {
+        return m_matrix.size();
+    }
+    if (!m_symbolSize.isValid()) {
+        m_symbolSize = symbolInfo().size;
+    }
+    return m_symbolSize;
+}
+
+void AbstractBarcodePrivate::colorize()
+{
+    if (!m_cache.isNull() || m_matrix.isNull()) {
+        return;
+    }
+
+    m_cache = Rasterizer::render(m_matrix, 1, 1, m_foreground.rgba(), m_background.rgba());
+}
+
+QImage AbstractBarcodePrivate::scaledImage(int scaleX, int scaleY)
+{
+    auto it = std::find_if(m_scaledCache.begin(), m_scaledCache.end(), [scaleX, scaleY](const auto &entry) {
+        return entry.scaleX == scaleX && entry.scaleY == scaleY;
+    });
+    if (it == m_scaledCache.end()) {
+        if (m_scaledCache.size() == ScaledCacheSize) {
+            m_scaledCache.pop_back();
         }
+        m_scaledCache.insert(m_scaledCache.begin(), ScaledImage{scaleX, scaleY, Rasterizer::render(m_matrix, scaleX, scaleY, m_foreground.rgba(), m_background.rgba())});
+    } else {
+        std::rotate(m_scaledCache.begin(), it, it + 1);
     }
+    return m_scaledCache.front().image;
+}
+
+void AbstractBarcodePrivate::reset()
+{
+    m_matrix = {};
+    m_symbolSize = {};
+    m_rectangles.clear();
+    resetImages();
+}
+
+void AbstractBarcodePrivate::resetImages()
+{
+    m_cache = QImage();
+    m_scaledCache.clear();
+}
 
-    explicit AbstractBarcodePrivate(AbstractBarcode *barcode)
-        : q(barcode)
-    {
+// the encoded matrix is color independent, so color changes only need the images to be rendered again
+void AbstractBarcodePrivate::colorsChanged()
+{
+    if (m_matrixDependsOnColors) {
+        reset();
+    } else {
+        resetImages();
     }
-};
-/**
- * @endcond
- */
+}
 
 #if PRISON_BUILD_DEPRECATED_SINCE(5, 69)
 AbstractBarcode::AbstractBarcode()
@@ -86,82 +220,201 @@ QByteArray AbstractBarcode::byteArrayData() const
 QImage AbstractBarcode::toImage(const QSizeF &size)
 {
     d->recompute();
-    if (d->m_cache.isNull() || d->sizeTooSmall(size)) {
+    if (d->m_matrix.isNull() || d->sizeTooSmall(size)) {
         return QImage();
     }
 
-    // scale to the requested size, using only full integer factors to keep the code readable
-    int scaleX = std::max<int>(1, size.width() / d->m_cache.width());
-    int scaleY = std::max<int>(1, size.height() / d->m_cache.height());
-    if (dimensions() == TwoDimensions) {
+    int scaleX, scaleY;
+    d->scaleFor(size, &scaleX, &scaleY);
+    if (scaleX == 1 && scaleY == 1) {
+        d->colorize();
+        return d->m_cache;
+    }
+    return d->scaledImage(scaleX, scaleY);
+}
+
+bool AbstractBarcode::renderTo(uchar *data, const QSize &size, int bytesPerLine, QImage::Format format) const
+{
+    d->recompute();
+    if (!data || d->m_matrix.isNull() || d->sizeTooSmall(size) || !Rasterizer::isSupportedFormat(format)) {
+        return false;
+    }
+    const auto depth = QImage::toPixelFormat(format).bitsPerPixel();
+    if (bytesPerLine < (size.width() * depth + 7) / 8) {
+        return false;
+    }
+
+    int scaleX, scaleY;
+    d->scaleFor(size, &scaleX, &scaleY);
+    Rasterizer::render(d->m_matrix, scaleX, scaleY, d->m_foreground.rgba(), d->m_background.rgba(), data, size, bytesPerLine, format);
+    return true;
+}
+
+bool AbstractBarcode::writeVector(QIODevice *device, VectorFormat format, const QSizeF &size) const
+{
+    d->recompute();
+    if (!device || d->m_matrix.isNull()) {
+        return false;
+    }
+
+    const auto outputSize = size.isEmpty() ? preferredSize(1.0) : size;
+    auto scaleX = outputSize.width() / d->m_matrix.width();
+    auto scaleY = outputSize.height() / d->m_matrix.height();
+    if (d->m_dimension == TwoDimensions) {
         scaleX = scaleY = std::min(scaleX, scaleY);
     }
+    return Vectorizer::write(device,
+                             format,
+                             d->m_matrix,
+                             QSizeF(d->m_matrix.width() * scaleX, d->m_matrix.height() * scaleY),
+                             d->m_foreground.rgba(),
+                             d->m_background.rgba());
+}
+
+void AbstractBarcode::paint(QPainter *painter, const QRectF &rect) const
+{
+    d->recompute();
+    if (!painter || d->m_matrix.isNull() || rect.isEmpty()) {
+        return;
+    }
+    if (d->m_rectangles.isEmpty()) {
+        d->m_rectangles = Vectorizer::rectangles(d->m_matrix);
+    }
+
+    const auto width = d->m_matrix.width();
+    const auto height = d->m_matrix.height();
+    const auto transform = painter->deviceTransform();
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing, false);
+    painter->setPen(Qt::NoPen);
+
+    if (transform.type() <= QTransform::TxScale) {
+        // work in device pixels, with integer module sizes
+        const auto deviceRect = transform.mapRect(rect);
+        auto moduleWidth = int(deviceRect.width() / width);
+        auto moduleHeight = int(deviceRect.height() / height);
+        if (d->m_dimension == TwoDimensions) {
+            moduleWidth = moduleHeight = std::min(moduleWidth, moduleHeight);
+        }
+        if (moduleWidth < 1 || moduleHeight < 1) {
+            painter->restore();
+            return;
+        }
+
+        const QRect barcodeRect(qRound(deviceRect.x() + (deviceRect.width() - width * moduleWidth) / 2.0),
+                                qRound(deviceRect.y() + (deviceRect.height() - height * moduleHeight) / 2.0),
+                                width * moduleWidth,
+                                height * moduleHeight);
+        painter->resetTransform();
+        if (d->m_background.alpha()) {
+            painter->fillRect(barcodeRect, d->m_background);
+        }
+
+        QVector<QRect> rects;
+        rects.reserve(d->m_rectangles.size());
+        for (const auto &r : std::as_const(d->m_rectangles)) {
+            rects.push_back(
+                QRect(barcodeRect.x() + r.x() * moduleWidth, barcodeRect.y() + r.y() * moduleHeight, r.width() * moduleWidth, r.height() * moduleHeight));
+        }
+        painter->setBrush(d->m_foreground);
+        painter->drawRects(rects);
+    } else {
+        auto moduleWidth = rect.width() / width;
+        auto moduleHeight = rect.height() / height;
+        if (d->m_dimension == TwoDimensions) {
+            moduleWidth = moduleHeight = std::min(moduleWidth, moduleHeight);
+        }
+        const QRectF barcodeRect(rect.x() + (rect.width() - width * moduleWidth) / 2.0,
+                                 rect.y() + (rect.height() - height * moduleHeight) / 2.0,
+                                 width * moduleWidth,
+                                 height * moduleHeight);
+        if (d->m_background.alpha()) {
+            painter->fillRect(barcodeRect, d->m_background);
+        }
+
+        QVector<QRectF> rects;
+        rects.reserve(d->m_rectangles.size());
+        for (const auto &r : std::as_const(d->m_rectangles)) {
+            rects.push_back(
+                QRectF(barcodeRect.x() + r.x() * moduleWidth, barcodeRect.y() + r.y() * moduleHeight, r.width() * moduleWidth, r.height() * moduleHeight));
+        }
+        painter->setBrush(d->m_foreground);
+        painter->drawRects(rects);
+    }
+
+    painter->restore();
+}
 
-    QImage out(d->m_cache.width() * scaleX, d->m_cache.height() * scaleY, d->m_cache.format());
-    QPainter p(&out);
-    p.setRenderHint(QPainter::SmoothPixmapTransform, false);
-    p.drawImage(out.rect(), d->m_cache, d->m_cache.rect());
-    return out;
+BarcodeMatrix AbstractBarcode::matrix() const
+{
+    d->recompute();
+    return d->m_matrix;
 }
 
 void AbstractBarcode::setData(const QString &data)
 {
+    if (d->m_data.type() == QVariant::String && d->m_data.toString() == data) {
+        return;
+    }
     d->m_data = data;
-    d->m_cache = QImage();
+    d->reset();
 }
 
 void AbstractBarcode::setData(const QByteArray &data)
 {
+    if (d->m_data.type() == QVariant::ByteArray && d->m_data.toByteArray() == data) {
+        return;
+    }
     d->m_data = data;
-    d->m_cache = QImage();
+    d->reset();
 }
 
 #if PRISON_BUILD_DEPRECATED_SINCE(5, 72)
 QSizeF AbstractBarcode::minimumSize() const
 {
-    d->recompute();
+    const auto size = d->symbolSize();
 
     // ### backward compatibility: this is applying minimum size behavior that the specific
     // implementations were doing prior to 5.69. This is eventually to be dropped.
-    if (d->m_cache.isNull()) {
+    if (size.isEmpty()) {
         return {};
     }
     switch (d->m_dimension) {
     case NoDimensions:
         return {};
     case OneDimension:
-        return QSizeF(d->m_cache.width(), std::max(d->m_cache.height(), 10));
+        return QSizeF(size.width(), std::max(size.height(), 10));
     case TwoDimensions:
-        return d->m_cache.size() * 4;
+        return size * 4;
     }
 
-    return d->m_cache.size();
+    return size;
 }
 #endif
 
 QSizeF AbstractBarcode::trueMinimumSize() const
 {
-    d->recompute();
-    return d->m_cache.size();
+    return d->symbolSize();
 }
 
 QSizeF AbstractBarcode::preferredSize(qreal devicePixelRatio) const
 {
-    d->recompute();
+    const auto size = d->symbolSize();
     switch (d->m_dimension) {
     case NoDimensions:
         return {};
     case OneDimension:
-        return QSizeF(d->m_cache.width() * (devicePixelRatio < 2 ? 2 : 1), std::max(d->m_cache.height(), 50));
+        return QSizeF(size.width() * (devicePixelRatio < 2 ? 2 : 1), std::max(size.height(), 50));
     case TwoDimensions:
         // TODO KF6: clean this up once preferredSize is virtual
 #if HAVE_ZXING
         // the smallest element of a PDF417 code is 1x 3px, for Aztec/QR/DataMatrix it's just 1x1 px
         if (dynamic_cast<const Pdf417Barcode *>(this)) {
-            return d->m_cache.size() * (devicePixelRatio < 2 ? 2 : 1);
+            return size * (devicePixelRatio < 2 ? 2 : 1);
         }
 #endif
-        return d->m_cache.size() * (devicePixelRatio < 2 ? 4 : 2);
+        return size * (devicePixelRatio < 2 ? 4 : 2);
     }
     return {};
 }
@@ -187,7 +440,7 @@ void AbstractBarcode::setBackgroundColor(const QColor &backgroundcolor)
 {
     if (backgroundcolor != backgroundColor()) {
         d->m_background = backgroundcolor;
-        d->m_cache = QImage();
+        d->colorsChanged();
     }
 }
 
@@ -195,7 +448,7 @@ void AbstractBarcode::setForegroundColor(const QColor &foregroundcolor)
 {
     if (foregroundcolor != foregroundColor()) {
         d->m_foreground = foregroundcolor;
-        d->m_cache = QImage();
+        d->colorsChanged();
     }
 }
 
@@ -204,4 +457,17 @@ AbstractBarcode::Dimensions AbstractBarcode::dimensions() const
     return d->m_dimension;
 }
 
+AztecOptions AbstractBarcode::aztecOptions() const
+{
+    return d->m_aztecOptions;
+}
+
+void AbstractBarcode::setAztecOptions(const AztecOptions &options)
+{
+    if (options != d->m_aztecOptions) {
+        d->m_aztecOptions = options;
+        d->reset();
+    }
+}
+
 AbstractBarcode::~AbstractBarcode() = default;
@@ -6,6 +6,8 @@
 
 #ifndef PRISON_ABSTRACTBARCODE_H
 #define PRISON_ABSTRACTBARCODE_H
+#include "barcodematrix.h"
+
 #include <QImage>
 #include <QSizeF>
 #include <QString>
@@ -15,19 +17,63 @@
 #include <memory>
 
 class QColor;
+class QIODevice;
+class QPainter;
 
 namespace Prison
 {
+/**
+ * Encoding parameters for Aztec codes.
+ * @see AbstractBarcode::setAztecOptions()
+ * @since 5.104
+ */
+struct AztecOptions {
+    /** Symbol formats an Aztec code can be encoded in. */
+    enum Format : uint8_t {
+        AnyFormat, ///< The smallest fitting compact or full symbol.
+        CompactFormat, ///< Only compact symbols, with up to 4 data layers.
+        FullFormat, ///< Only full symbols, with up to 32 data layers.
+    };
+
+    /** Minimum share of the symbol capacity reserved for error correction, in percent.
+     *  The default of 23% is what ISO/IEC 24778 recommends. Lower values result in smaller
+     *  symbols, at the expense of robustness against damage and bad scanning conditions.
+     *  There is always at least one error correction code word.
+     */
+    int errorCorrectionPercent = 23;
+    /** Restricts the symbol format, by default the smallest fitting symbol is used. */
+    Format format = AnyFormat;
+    /** Minimum number of data layers. Content fitting into fewer layers uses the additional
+     *  space for error correction, which allows to produce symbols of a fixed size.
+     */
+    int minimumLayerCount = 1;
+    /** Maximum number of data layers. Content not fitting into this results in an empty barcode. */
+    int maximumLayerCount = 32;
+
+    inline bool operator==(const AztecOptions &other) const
+    {
+        return errorCorrectionPercent == other.errorCorrectionPercent && format == other.format && minimumLayerCount == other.minimumLayerCount
+            && maximumLayerCount == other.maximumLayerCount;
+    }
+    inline bool operator!=(const AztecOptions &other) const
+    {
+        return !operator==(other);
+    }
+};
+
 /**
  * base class for barcode generators
  * To add your own barcode generator, subclass this class
- * and reimplement toImage(const QSizeF&) to do the actual
+ * and reimplement paintImage(const QSizeF&) to do the actual
  * work of generating the barcode.
  *
- * The barcode is cached in AbstractBarcode when painting and
- * the size and the data doesn't change. Using the same AbstractBarcode
- * to paint on several surfaces, if they aren't of the exact same size
- * will break the caching
+ * The encoded barcode is cached in AbstractBarcode as long as
+ * the data doesn't change, rendering it at different sizes
+ * does not require encoding it again.
+ *
+ * As this cache is populated on demand even from const methods,
+ * an AbstractBarcode instance must not be used from multiple threads
+ * at the same time. Use Prison::encode() for that instead.
  */
 class PRISON_EXPORT AbstractBarcode
 {
@@ -80,9 +126,86 @@ public:
      *
      * If one of the dimensions of @param size is smaller than the matching dimension in \ref minimumSize,
      * a null QImage will be returned
+     *
+     * The resulting images are cached for a few recently requested sizes, so repeatedly
+     * calling this with the same size is cheap.
      */
     QImage toImage(const QSizeF &size);
 
+    /**
+     * Renders the barcode into a caller-provided buffer, without allocating any memory.
+     *
+     * The barcode is scaled the same way as by toImage() for a requested size of @p size,
+     * placed in the top left corner of the buffer, and the remaining area is filled with
+     * backgroundColor().
+     *
+     * Supported formats are QImage::Format_Mono, QImage::Format_Grayscale8, QImage::Format_Indexed8,
+     * QImage::Format_RGB32, QImage::Format_ARGB32 and QImage::Format_ARGB32_Premultiplied.
+     * For QImage::Format_Mono and QImage::Format_Indexed8 the barcode is written as color
+     * index 1 and the background as color index 0, the color table is up to the caller then.
+     *
+     * @param data Pointer to the first pixel of the buffer.
+     * @param size Size of the buffer, in pixels.
+     * @param bytesPerLine Distance between the start of two consecutive lines in the buffer, in bytes.
+     * @param format Pixel format of the buffer.
+     * @return @c false if the format is not supported, the buffer is too small for the barcode,
+     * or if there is no barcode to render. The buffer is left untouched in that case.
+     * @since 5.104
+     */
+    bool renderTo(uchar *data, const QSize &size, int bytesPerLine, QImage::Format format) const;
+
+    /**
+     * Vector graphics formats supported by writeVector().
+     * @since 5.104
+     */
+    enum VectorFormat {
+        SvgFormat, ///< Scalable Vector Graphics document.
+        EpsFormat, ///< Encapsulated PostScript document.
+        PdfFormat, ///< Single page PDF document.
+    };
+
+    /**
+     * Writes the barcode as vector graphics document to @p device.
+     *
+     * Adjacent set modules are merged into larger rectangles, resulting in a compact
+     * document that can be scaled arbitrarily without loss of quality. Transparency of
+     * the foreground and background colors is only supported for SVG output, a fully
+     * transparent background is omitted in all formats though.
+     *
+     * @param device An open, writable device.
+     * @param format The document format.
+     * @param size Output size, in pixels for SVG and in points for EPS and PDF. For
+     * two-dimensional barcodes the aspect ratio is preserved, so the output might be smaller
+     * in one dimension. If empty, preferredSize(1) is used.
+     * @return @c false if there is no barcode to write, or writing to @p device failed.
+     * @since 5.104
+     */
+    bool writeVector(QIODevice *device, VectorFormat format, const QSizeF &size = QSizeF()) const;
+
+    /**
+     * Draws the barcode into @p rect using @p painter, without an intermediate image.
+     *
+     * Modules are sized in full device pixels, so the result is sharp on any paint device,
+     * including printers and PDF output. For two-dimensional barcodes the aspect ratio is
+     * preserved, and the barcode is centered in @p rect. Nothing is drawn if @p rect is
+     * too small to fit at least one device pixel per module.
+     * If @p painter has a rotation or shear transformation set, modules are not aligned
+     * to device pixels.
+     *
+     * @since 5.104
+     */
+    void paint(QPainter *painter, const QRectF &rect) const;
+
+    /**
+     * The encoded barcode as a grid of modules, without any scaling or coloring applied.
+     * This is what toImage() is based on, and is the cheapest way to obtain the barcode
+     * content when rendering it yourself.
+     * @return the module matrix, or a null matrix if there is no data or the data
+     * could not be encoded.
+     * @since 5.104
+     */
+    BarcodeMatrix matrix() const;
+
 #if PRISON_ENABLE_DEPRECATED_SINCE(5, 72)
     /**
      * The minimal size of this barcode.
@@ -149,6 +272,19 @@ public:
      */
     Dimensions dimensions() const;
 
+    /**
+     * Encoding parameters used for Aztec codes.
+     * @see setAztecOptions()
+     * @since 5.104
+     */
+    AztecOptions aztecOptions() const;
+    /**
+     * Sets the encoding parameters used for Aztec codes.
+     * This has no effect on other barcode types.
+     * @since 5.104
+     */
+    void setAztecOptions(const AztecOptions &options);
+
 protected:
     ///@cond internal
     explicit AbstractBarcode(Dimensions dim);
@@ -167,6 +303,13 @@ protected:
 
     /**
      * Doing the actual painting of the image
+     *
+     * The built-in barcode generators return a QImage::Format_Mono image here
+     * with one pixel per module, color index 1 denoting set modules. This is used
+     * as the module matrix directly. Images in any other format are interpreted as
+     * an already colorized barcode, with every pixel that doesn't match backgroundColor()
+     * being considered a set module.
+     *
      * @param size unused - will be removed in KF6
      * @return image with barcode, or null image
      */
@@ -0,0 +1,77 @@
+/*
+    SPDX-FileCopyrightText: 2010-2016 Sune Vuorela <sune@vuorela.dk>
+
+    SPDX-License-Identifier: MIT
+*/
+
+#ifndef PRISON_ABSTRACTBARCODE_P_H
+#define PRISON_ABSTRACTBARCODE_P_H
+
+#include "abstractbarcode.h"
+#include "prison.h"
+
+#include <QColor>
+#include <QImage>
+#include <QRect>
+#include <QVariant>
+#include <QVector>
+
+#include <vector>
+
+namespace Prison
+{
+
+class AbstractBarcodePrivate
+{
+public:
+    explicit AbstractBarcodePrivate(AbstractBarcode *barcode);
+
+    static inline AbstractBarcodePrivate *get(AbstractBarcode *q)
+    {
+        return q->d.get();
+    }
+
+    bool sizeTooSmall(const QSizeF &size) const;
+    void scaleFor(const QSizeF &size, int *scaleX, int *scaleY) const;
+    bool isEmpty() const;
+    /** Generator specific parameters changing the encoding result, as part of the symbol cache key. */
+    QByteArray encodingParameters() const;
+
+    void recompute();
+    /** Encodes the current content, bypassing both m_matrix and the symbol cache. */
+    BarcodeMatrix encode();
+    SymbolInfo symbolInfo();
+    /** Size of the barcode in modules, avoiding a full encoding if possible. */
+    QSize symbolSize();
+    void colorize();
+    QImage scaledImage(int scaleX, int scaleY);
+
+    void reset();
+    void resetImages();
+    void colorsChanged();
+
+    QVariant m_data;
+    BarcodeMatrix m_matrix;
+    QSize m_symbolSize; // from symbolInfo(), while m_matrix hasn't been computed yet
+    QVector<QRect> m_rectangles; // m_matrix as merged rectangles, for painting
+    QImage m_cache; // m_matrix colorized, at a scale of 1
+    struct ScaledImage {
+        int scaleX;
+        int scaleY;
+        QImage image;
+    };
+    // enough for a barcode shown at a few sizes, or on screens with different device pixel ratios
+    static constexpr std::size_t ScaledCacheSize = 4;
+    std::vector<ScaledImage> m_scaledCache; // most recently used first
+    bool m_matrixDependsOnColors = false; // true for legacy paintImage() implementations producing colored images
+    QColor m_foreground = Qt::black;
+    QColor m_background = Qt::white;
+    AbstractBarcode::Dimensions m_dimension = AbstractBarcode::NoDimensions;
+    AztecOptions m_aztecOptions;
+    BarcodeType m_type = Null; // only set for built-in generators, whose output can be shared via the symbol cache
+    AbstractBarcode *q;
+};
+
+}
+
+#endif // PRISON_ABSTRACTBARCODE_P_H
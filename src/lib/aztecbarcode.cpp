@@ -5,14 +5,20 @@
 */
 
 #include "aztecbarcode.h"
+#include "barcodematrix_p.h"
 #include "bitvector_p.h"
 #include "prison_debug.h"
 #include "reedsolomon_p.h"
 
 #include <QImage>
-#include <QPainter>
+#include <QVarLengthArray>
+#include <QtEndian>
 
 #include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
 #include <vector>
 
 // see https://en.wikipedia.org/wiki/Aztec_Code for encoding tables, magic numbers, etc
@@ -51,107 +57,194 @@ static const aztec_layer_property_t aztec_layer_properties[] = {{2, 6, ReedSolom
                                                                 {32, 12, ReedSolomon::GF4096}};
 
 // amounts of bits in an Aztec code depending on layer count
-static int aztecCompactDataBits(int layer)
+static constexpr int aztecCompactDataBits(int layer)
 {
     return (88 + 16 * layer) * layer;
 }
 
-static int aztecFullDataBits(int layer)
+static constexpr int aztecFullDataBits(int layer)
 {
     return (112 + 16 * layer) * layer;
 }
 
-QImage AztecBarcode::paintImage(const QSizeF &size)
+static const aztec_layer_property_t &aztecLayerProperty(int layerCount)
 {
-    Q_UNUSED(size);
-    const auto inputData = aztecEncode(data().isEmpty() ? byteArrayData() : data().toLatin1());
+    return *std::lower_bound(aztec_layer_properties, aztec_layer_properties + 4, layerCount, [](const aztec_layer_property_t &lhs, int rhs) {
+        return lhs.layer < rhs;
+    });
+}
 
-    int layerCount = 0;
-    int codewordCount = 0;
-    int availableBits = 0;
-    int stuffSize = 0; // extra bits added during bit stuffing, which might make us overrun the available size
-    bool compactMode = false;
-    BitVector encodedData;
+// offsets of the data layers relative to the maximum symbol size, depending on layer count
+static constexpr int aztecFullLayerOffset[] = {
+    //   0   1   2   3   4   5   6   7   8   9  10  11  12  13  14  15  16  17  18  19  20  21  22  23  24  25  26 27 28 29 30 31
+    66, 64, 62, 60, 57, 55, 53, 51, 49, 47, 45, 42, 40, 38, 36, 34, 32, 30, 28, 25, 23, 21, 19, 17, 15, 13, 10, 8, 6, 4, 2, 0};
 
-    do {
-        layerCount = 0;
-        // find the smallest layout we can put the data in, while leaving 23% for error correction
-        for (auto i = 1; i <= FullLayerCount; ++i) {
-            if (aztecFullDataBits(i) * 0.77 > (inputData.size() + stuffSize)) {
-                layerCount = i;
-                break;
-            }
+static constexpr int aztecCompactLayerOffset[] = {6, 4, 2, 0};
+
+bool AztecBarcode::selectLayout(const BitVector &inputData, int *layerCount, bool *compactMode, BitVector *stuffedData) const
+{
+    const auto options = aztecOptions();
+    const auto dataShare = (100 - std::clamp(options.errorCorrectionPercent, 0, 99)) / 100.0;
+
+    // bit stuffing only depends on the code word size, so it is done at most once for each of those
+    std::array<BitVector, std::size(aztec_layer_properties)> stuffed;
+    std::array<bool, std::size(aztec_layer_properties)> isStuffed = {};
+
+    // find the smallest allowed layout we can put the data in, while leaving the requested share for error correction,
+    // compact layouts are smaller than full ones with the same capacity
+    for (const auto compact : {true, false}) {
+        if (options.format == (compact ? AztecOptions::FullFormat : AztecOptions::CompactFormat)) {
+            continue;
         }
-        for (auto i = 1; i <= CompactLayerCount; ++i) {
-            if (aztecCompactDataBits(i) * 0.77 > (inputData.size() + stuffSize)) {
-                layerCount = i;
-                compactMode = true;
-                break;
+        const auto maxLayerCount = std::min<int>(options.maximumLayerCount, compact ? CompactLayerCount : FullLayerCount);
+        for (int i = std::max(options.minimumLayerCount, 1); i <= maxLayerCount; ++i) {
+            const auto availableBits = compact ? aztecCompactDataBits(i) : aztecFullDataBits(i);
+            if (availableBits * dataShare <= inputData.size()) {
+                continue;
+            }
+
+            // bit stuffing and padding might still overrun the available size
+            const auto &prop = aztecLayerProperty(i);
+            const auto idx = std::distance(aztec_layer_properties, &prop);
+            if (!isStuffed[idx]) {
+                stuffed[idx] = bitStuffAndPad(inputData, prop.codeWordSize);
+                isStuffed[idx] = true;
+            }
+
+            // we need at least one error correction code word, and the compact mode message can't represent more than 64 data code words
+            const auto codewordCount = stuffed[idx].size() / prop.codeWordSize;
+            if (codewordCount < availableBits / prop.codeWordSize && (!compact || codewordCount <= 64)) {
+                *layerCount = i;
+                *compactMode = compact;
+                *stuffedData = std::move(stuffed[idx]);
+                return true;
             }
         }
-        if (layerCount == 0) {
-            qCWarning(Log) << "data too large for Aztec code" << inputData.size();
-            return {};
-        }
+    }
+    return false;
+}
+
+SymbolInfo AztecBarcode::symbolInfo() const
+{
+    const auto inputData = aztecEncode(data().isEmpty() ? byteArrayData() : data().toLatin1());
 
-        // determine code word size
-        const auto propIt = std::lower_bound(aztec_layer_properties, aztec_layer_properties + 4, layerCount, [](const aztec_layer_property_t &lhs, int rhs) {
-            return lhs.layer < rhs;
-        });
+    SymbolInfo info;
+    BitVector stuffedData;
+    info.fits = selectLayout(inputData, &info.version, &info.compact, &stuffedData);
+    if (info.fits) {
+        const auto size =
+            info.compact ? CompactMaxSize - 2 * aztecCompactLayerOffset[info.version - 1] : FullMaxSize - 2 * aztecFullLayerOffset[info.version - 1];
+        info.size = QSize(size, size);
+    }
+    return info;
+}
 
-        // bit stuffing
-        auto stuffedData = bitStuffAndPad(inputData, (*propIt).codeWordSize);
-        stuffSize = stuffedData.size() - inputData.size();
+bool AztecBarcode::encodeSymbol(BitVector *encodedData, BitVector *modeMsg, int *layerCount, bool *compactMode) const
+{
+    const auto inputData = aztecEncode(data().isEmpty() ? byteArrayData() : data().toLatin1());
 
-        availableBits = compactMode ? aztecCompactDataBits(layerCount) : aztecFullDataBits(layerCount);
-        codewordCount = stuffedData.size() / (*propIt).codeWordSize;
-        const auto rsWordCount = availableBits / (*propIt).codeWordSize - codewordCount;
+    BitVector stuffedData;
+    if (!selectLayout(inputData, layerCount, compactMode, &stuffedData)) {
+        qCWarning(Log) << "data too large for Aztec code" << inputData.size();
+        return false;
+    }
 
-        // compute error correction
-        ReedSolomon rs((*propIt).gf, rsWordCount);
-        const auto rsData = rs.encode(stuffedData);
+    const auto &prop = aztecLayerProperty(*layerCount);
+    const auto availableBits = *compactMode ? aztecCompactDataBits(*layerCount) : aztecFullDataBits(*layerCount);
+    const auto codewordCount = stuffedData.size() / prop.codeWordSize;
+    const auto rsWordCount = availableBits / prop.codeWordSize - codewordCount;
 
-        // pad with leading 0 bits to align to code word boundaries
-        encodedData.reserve(availableBits);
-        if (int diff = availableBits - stuffedData.size() - rsData.size()) {
-            encodedData.appendMSB(0, diff);
-        }
-        encodedData.append(stuffedData);
-        encodedData.append(rsData);
+    // compute error correction
+    ReedSolomon rs(prop.gf, rsWordCount);
+    const auto rsData = rs.encode(stuffedData);
 
-        // try again in the rare case that we overrun the available bits due to bit stuffing and padding
-    } while (encodedData.size() > availableBits);
+    // pad with leading 0 bits to align to code word boundaries
+    encodedData->clear();
+    encodedData->reserve(availableBits);
+    if (int diff = availableBits - stuffedData.size() - rsData.size()) {
+        encodedData->appendMSB(0, diff);
+    }
+    encodedData->append(stuffedData);
+    encodedData->append(rsData);
 
     // determine mode message
-    BitVector modeMsg;
-    if (compactMode) {
-        modeMsg.appendMSB(layerCount - 1, 2);
-        modeMsg.appendMSB(codewordCount - 1, 6);
+    modeMsg->clear();
+    if (*compactMode) {
+        modeMsg->appendMSB(*layerCount - 1, 2);
+        modeMsg->appendMSB(codewordCount - 1, 6);
         ReedSolomon rs(ReedSolomon::GF16, 5);
-        modeMsg.append(rs.encode(modeMsg));
+        modeMsg->append(rs.encode(*modeMsg));
     } else {
-        modeMsg.appendMSB(layerCount - 1, 5);
-        modeMsg.appendMSB(codewordCount - 1, 11);
+        modeMsg->appendMSB(*layerCount - 1, 5);
+        modeMsg->appendMSB(codewordCount - 1, 11);
         ReedSolomon rs(ReedSolomon::GF16, 6);
-        modeMsg.append(rs.encode(modeMsg));
+        modeMsg->append(rs.encode(*modeMsg));
     }
 
-    // render the result
+    return true;
+}
+
+// reads @p count code words of @p codeWordSize bits from @p data, and checks their error correction
+static bool aztecCheckCodewords(BitVectorView data, int codeWordSize, int gf, int eccCount, QVarLengthArray<quint16, 256> *codewords)
+{
+    const auto count = data.size() / codeWordSize;
+    codewords->resize(count);
+    auto reader = data.reader();
+    for (auto &codeword : *codewords) {
+        codeword = quint16(reader.read(codeWordSize));
+    }
+    ReedSolomon rs(gf, eccCount);
+    return rs.decode(codewords->data(), count) == 0;
+}
+
+bool AztecBarcode::verifyCodewords(const BitVector &encodedData, const BitVector &modeMsg, bool compactMode)
+{
+    // the mode message tells us the layer and data code word count, like it would for a reader
+    QVarLengthArray<quint16, 256> codewords;
+    if (modeMsg.size() != (compactMode ? CompactModeMessageSize : FullModeMessageSize)
+        || !aztecCheckCodewords(modeMsg, 4, ReedSolomon::GF16, compactMode ? 5 : 6, &codewords)) {
+        return false;
+    }
+    const auto mode = compactMode ? (codewords[0] << 4) | codewords[1] : (codewords[0] << 12) | (codewords[1] << 8) | (codewords[2] << 4) | codewords[3];
+    const auto layerCount = (compactMode ? mode >> 6 : mode >> 11) + 1;
+    const auto codewordCount = (compactMode ? mode & 0x3f : mode & 0x7ff) + 1;
+
+    const auto availableBits = compactMode ? aztecCompactDataBits(layerCount) : aztecFullDataBits(layerCount);
+    if (encodedData.size() != availableBits) {
+        return false;
+    }
+    const auto &prop = aztecLayerProperty(layerCount);
+    const auto padding = availableBits % prop.codeWordSize;
+    const auto rsWordCount = availableBits / prop.codeWordSize - codewordCount;
+    return rsWordCount > 0
+        && aztecCheckCodewords(BitVectorView(encodedData, padding, availableBits - padding), prop.codeWordSize, prop.gf, rsWordCount, &codewords);
+}
+
+QImage AztecBarcode::paintImage(const QSizeF &size)
+{
+    Q_UNUSED(size);
+
+    int layerCount = 0;
+    bool compactMode = false;
+    BitVector encodedData;
+    BitVector modeMsg;
+    if (!encodeSymbol(&encodedData, &modeMsg, &layerCount, &compactMode)) {
+        return {};
+    }
+
+    // render the result, starting from a copy of the finder pattern and reference grid for this size
+    QImage modules;
     if (compactMode) {
-        QImage img(CompactMaxSize, CompactMaxSize, QImage::Format_RGB32);
-        img.fill(backgroundColor());
-        paintCompactGrid(&img);
-        paintCompactData(&img, encodedData, layerCount);
-        paintCompactModeMessage(&img, modeMsg);
-        return cropAndScaleCompact(&img, layerCount);
+        modules = compactTemplate(layerCount);
+        paintCompactData(&modules, encodedData, layerCount);
+        paintCompactModeMessage(&modules, modeMsg);
     } else {
-        QImage img(FullMaxSize, FullMaxSize, QImage::Format_RGB32);
-        img.fill(backgroundColor());
-        paintFullGrid(&img);
-        paintFullData(&img, encodedData, layerCount);
-        paintFullModeMessage(&img, modeMsg);
-        return cropAndScaleFull(&img, layerCount);
+        modules = fullTemplate(layerCount);
+        paintFullData(&modules, encodedData, layerCount);
+        paintFullModeMessage(&modules, modeMsg);
     }
+    Q_ASSERT(verifySymbol(modules, compactMode));
+    return modules;
 }
 
 // code points and encoding modes for each of the first 127 ASCII characters, the rest is encoded in Binary mode
@@ -180,7 +273,7 @@ struct aztec_code_t {
     uint8_t mode;
 };
 
-static const aztec_code_t aztec_code_table[] = {
+static constexpr aztec_code_t aztec_code_table[] = {
     {0, Binary}, // 0
     {2, Mixed},       {3, Mixed},       {4, Mixed},
     {5, Mixed},       {6, Mixed},       {7, Mixed},
@@ -247,7 +340,7 @@ static const aztec_code_t aztec_code_table[] = {
 };
 Q_STATIC_ASSERT(sizeof(aztec_code_table) == 256);
 
-static const struct {
+static constexpr struct {
     uint8_t c1;
     uint8_t c2;
     aztec_code_t sym;
@@ -258,11 +351,11 @@ static const struct {
     {':', ' ', {5, Punct}} // : SP
 };
 
-static const int aztec_code_size[] = {0, 5, 5, 5, 5, 4, 8};
+static constexpr int aztec_code_size[] = {0, 5, 5, 5, 5, 4, 8};
 Q_STATIC_ASSERT(sizeof(aztec_code_size) / sizeof(int) == MODE_COUNT);
 
 // codes for ambiguous characters, ie. those that can be encoded in multiple modes
-static const aztec_code_t aztec_special_chars[SPECIAL_CHAR_COUNT][MODE_COUNT] = {
+static constexpr aztec_code_t aztec_special_chars[SPECIAL_CHAR_COUNT][MODE_COUNT] = {
     /*   NoMode      Upper      Lower        Mixed        Punct      Digit     Binary  */
     {{0, NoMode}, {1, Upper}, {1, Lower}, {1, Mixed}, {1, Upper}, {1, Digit}, {0, NoMode}}, /* SP */
     {{0, NoMode}, {1, Punct}, {1, Punct}, {14, Mixed}, {1, Punct}, {1, Punct}, {0, NoMode}}, /* CR */
@@ -272,7 +365,7 @@ static const aztec_code_t aztec_special_chars[SPECIAL_CHAR_COUNT][MODE_COUNT] =
 
 // shift code table, source mode -> target mode
 // NoMode indicates shift is not available, use latch instead
-static const aztec_code_t aztec_shift_codes[MODE_COUNT - 1][MODE_COUNT - 1] = {
+static constexpr aztec_code_t aztec_shift_codes[MODE_COUNT - 1][MODE_COUNT - 1] = {
     /*     NoMode         Upper           Lower         Mixed          Punct          Digit   */
     {{0, NoMode}, {0, NoMode}, {0, NoMode}, {0, NoMode}, {0, NoMode}, {0, NoMode}},
     {{0, NoMode}, {0, NoMode}, {0, NoMode}, {0, NoMode}, {0, Punct}, {0, NoMode}},
@@ -282,7 +375,7 @@ static const aztec_code_t aztec_shift_codes[MODE_COUNT - 1][MODE_COUNT - 1] = {
     {{0, NoMode}, {15, Upper}, {0, NoMode}, {0, NoMode}, {0, Punct}, {0, NoMode}}};
 
 // latch code table, source mode -> target mode
-static const aztec_code_t aztec_latch_codes[MODE_COUNT - 1][MODE_COUNT] = {
+static constexpr aztec_code_t aztec_latch_codes[MODE_COUNT - 1][MODE_COUNT] = {
     /*     NoMode         Upper           Lower         Mixed          Punct          Digit          Binary */
     {{0, NoMode}, {0, NoMode}, {0, NoMode}, {0, NoMode}, {0, NoMode}, {0, NoMode}, {0, NoMode}},
     {{0, NoMode}, {0, NoMode}, {28, Lower}, {29, Mixed}, {29, Mixed}, {30, Digit}, {31, Binary}},
@@ -302,167 +395,469 @@ static Mode aztecCodeLatchTo(Mode currentMode, Mode targetMode, BitVector *v)
     return static_cast<Mode>(latchCode.mode);
 }
 
-static void aztecEncodeBinary(std::vector<aztec_code_t>::iterator &it, const std::vector<aztec_code_t>::iterator &end, BitVector *v)
-{
-    // determine length of the binary sequence
-    const auto binEndIt = std::find_if(it, end, [](aztec_code_t sym) {
-        return sym.mode != Binary;
-    });
-    const auto length = std::distance(it, binEndIt);
+// lookup tables for the encoder, derived from the code tables above at compile time
+struct aztec_encoding_tables_t {
+    constexpr aztec_encoding_tables_t()
+    {
+        for (int c = 0; c < 256; ++c) {
+            chars[c].doubleCharCode = -1;
+            for (int mode = Upper; mode <= Digit; ++mode) {
+                chars[c].code[mode] = -1;
+                if (c > 127) {
+                    continue;
+                }
+                auto sym = aztec_code_table[c];
+                if (sym.mode == Special) {
+                    sym = aztec_special_chars[sym.code][mode];
+                }
+                if (sym.mode == mode) {
+                    chars[c].code[mode] = sym.code;
+                }
+            }
+        }
 
-    // write length field
-    qCDebug(Log) << "binary length" << length;
-    if (length < 32) {
-        v->appendMSB(length, 5);
-    } else {
-        v->appendMSB(0, 5);
-        v->appendMSB(length - 31, 11);
-    }
+        for (const auto &dblCode : aztec_code_double_symbols) {
+            chars[dblCode.c1].doubleCharCode = dblCode.sym.code;
+            chars[dblCode.c1].doubleCharSecond = dblCode.c2;
+        }
 
-    // write data
-    for (; it != binEndIt; ++it) {
-        qCDebug(Log) << "binary data" << (*it).code;
-        v->appendMSB((*it).code, 8);
+        for (int from = Upper; from <= Digit; ++from) {
+            for (int to = Upper; to <= Digit; ++to) {
+                int mode = from;
+                while (mode != to) {
+                    latchCost[from][to] += aztec_code_size[mode];
+                    mode = aztec_latch_codes[mode][to].mode;
+                }
+            }
+        }
     }
+
+    // everything needed to encode a byte, in a single 8 byte entry
+    struct {
+        // code of the byte in each mode, -1 if not encodable in that mode
+        int8_t code[Digit + 1];
+        // second byte and Punct code of the double character starting with this byte, code is -1 if there is none
+        uint8_t doubleCharSecond;
+        int8_t doubleCharCode;
+    } chars[256] = {};
+    // amount of bits needed to latch from one mode to another
+    uint8_t latchCost[Digit + 1][Digit + 1] = {};
+};
+static constexpr aztec_encoding_tables_t aztec_encoding_tables = {};
+Q_STATIC_ASSERT(aztec_encoding_tables.chars[' '].code[Punct] == -1 && aztec_encoding_tables.chars[' '].code[Digit] == 1);
+Q_STATIC_ASSERT(aztec_encoding_tables.chars['.'].doubleCharSecond == ' ' && aztec_encoding_tables.chars['.'].doubleCharCode == 3);
+Q_STATIC_ASSERT(aztec_encoding_tables.latchCost[Lower][Upper] == 9);
+
+// code of @p c in @p mode, or -1 if @p c cannot be encoded in that mode
+static inline int aztecCharCode(uint8_t c, Mode mode)
+{
+    return aztec_encoding_tables.chars[c].code[mode];
 }
 
-static void aztecEncodeResolveAmbigious(Mode currentMode, const std::vector<aztec_code_t>::iterator &begin, const std::vector<aztec_code_t>::iterator &end)
+// Punct code of the two character sequence @p c1 @p c2, or -1 if there is none
+static inline int aztecDoubleCharCode(uint8_t c1, uint8_t c2)
 {
-    Q_ASSERT(begin != end);
-    Q_ASSERT(currentMode != (*begin).mode);
-    Q_ASSERT((*begin).mode == Special);
+    const auto &entry = aztec_encoding_tables.chars[c1];
+    return entry.doubleCharSecond == c2 ? entry.doubleCharCode : -1;
+}
 
-    // forward search
-    auto it = begin;
-    for (; it != end && (*it).mode == Special; ++it) {
-        if (aztec_special_chars[(*it).code][currentMode].mode == currentMode) {
-            qCDebug(Log) << "special resolved to current mode by forward search";
-            (*it).mode = aztec_special_chars[(*it).code][currentMode].mode;
-            (*it).code = aztec_special_chars[(*it).code][currentMode].code;
-        }
+enum {
+    BinaryShortLength = 31,
+    BinaryMaxLength = 2047 + 31,
+};
+
+namespace
+{
+// one step of the shortest path through the encoding graph
+enum StepType : uint8_t {
+    NoStep,
+    DirectStep, // encode one character (or two for Punct double characters) in the current mode
+    ShiftStep, // same, but after a shift into shiftMode
+    BinaryStep, // binary shift sequence, returning to the current mode
+};
+
+// best way to reach a certain position in the input, in a certain mode
+struct AztecNode {
+    int cost = std::numeric_limits<int>::max();
+    int from = -1; // input position this step started at
+    StepType step = NoStep;
+    uint8_t mode = NoMode; // latched mode at the start of this step, or shift mode for ShiftStep
+};
+
+// best way to be in a certain mode at a certain position, after (possibly) latching
+struct AztecLatchedNode {
+    int cost = std::numeric_limits<int>::max();
+    uint8_t mode = NoMode; // mode of the arrival this latches from
+    // bookkeeping for finding the part of the path that is final already
+    int visited = 0;
+    int junction = 0;
+};
+
+// all nodes for one input position
+struct AztecPosition {
+    // best way to get to this position, without a trailing latch
+    std::array<AztecNode, Digit + 1> arrivals;
+    std::array<AztecLatchedNode, Digit + 1> latched;
+};
+
+// a latched node, identified by input position and mode. The start of the input is the only
+// node with mode NoMode.
+struct AztecNodeRef {
+    int pos;
+    int mode;
+    inline bool operator==(const AztecNodeRef &other) const
+    {
+        return pos == other.pos && mode == other.mode;
     }
+};
 
-    // backward search
-    auto backIt = it;
-    while (std::distance(begin, backIt) >= 1 && it != end) {
-        --backIt;
-        if ((*backIt).mode == Special && aztec_special_chars[(*backIt).code][(*it).mode].mode == (*it).mode) {
-            qCDebug(Log) << "special resolved by backward search";
-            (*backIt).mode = aztec_special_chars[(*backIt).code][(*it).mode].mode;
-            (*backIt).code = aztec_special_chars[(*backIt).code][(*it).mode].code;
-        } else {
-            break;
+// monotonic queue for sliding window minimum search over node positions
+class AztecWindowMin
+{
+public:
+    inline void push(int pos, int value)
+    {
+        while (m_head < m_queue.size() && m_queue.back().second >= value) {
+            m_queue.pop_back();
+        }
+        if (m_head == m_queue.size()) {
+            m_queue.clear();
+            m_head = 0;
         }
+        m_queue.emplace_back(pos, value);
     }
-
-    // pick one if we still have an ambiguous symbol
-    if ((*begin).mode != Special) {
-        return;
+    inline void popBefore(int pos)
+    {
+        while (m_head < m_queue.size() && m_queue[m_head].first < pos) {
+            ++m_head;
+        }
+    }
+    inline bool isEmpty() const
+    {
+        return m_head == m_queue.size();
+    }
+    inline const std::pair<int, int> &min() const
+    {
+        return m_queue[m_head];
     }
-    (*begin).mode = aztec_special_chars[(*begin).code][currentMode].mode;
-    (*begin).code = aztec_special_chars[(*begin).code][currentMode].code;
-    it = begin + 1;
-    if (it != end && (*it).mode == Special) {
-        aztecEncodeResolveAmbigious(static_cast<Mode>((*begin).mode), it, end);
+    // calls @p func for the positions of all entries that can still become the minimum
+    template<typename Func>
+    inline void forEach(Func func) const
+    {
+        for (auto i = m_head; i < m_queue.size(); ++i) {
+            func(m_queue[i].first);
+        }
     }
+
+private:
+    std::vector<std::pair<int, int>> m_queue;
+    std::size_t m_head = 0;
+};
+
+// one step of the shortest path, in encoding order
+struct AztecStep {
+    int from;
+    int to;
+    StepType step;
+    Mode mode; // mode the step is encoded in, or the latch target for NoStep
+    Mode shiftMode;
+};
 }
 
-static Mode aztecNextMode(Mode currentMode, const std::vector<aztec_code_t>::iterator &nextSym, const std::vector<aztec_code_t>::iterator &end, bool &tryShift)
+// appends @p count bytes from @p data, 8 bytes at a time
+static void aztecAppendBinary(const uint8_t *data, int count, BitVector *v)
 {
-    Q_ASSERT(currentMode != (*nextSym).mode);
-    Q_ASSERT(nextSym != end);
-    Q_ASSERT((*nextSym).mode != Special);
-    auto it = nextSym;
-    ++it;
-    if (it != end && (*it).mode == Special) {
-        aztecEncodeResolveAmbigious(static_cast<Mode>((*nextSym).mode), it, end);
+    for (; count >= 8; count -= 8, data += 8) {
+        v->appendMSB(qFromBigEndian<quint64>(data), 64);
     }
-
-    if ((it == end || (*it).mode == currentMode) && std::distance(nextSym, it) == 1) {
-        tryShift = true;
+    quint64 tail = 0;
+    for (int i = 0; i < count; ++i) {
+        tail = (tail << 8) | data[i];
     }
-
-    qCDebug(Log) << currentMode << (*nextSym).mode << tryShift << std::distance(nextSym, it);
-    return static_cast<Mode>((*nextSym).mode);
+    v->appendMSB(tail, 8 * count);
 }
 
+// Finds the shortest encoding by dynamic programming over the input positions and
+// latched modes, in a single forward pass using the per-byte encoding table above.
+// Binary shift sequences of all lengths are considered via a sliding window minimum
+// over their start positions.
+// Every few hundred positions, the shortest paths to all nodes later steps can start from
+// are compared. The part they have in common is final, and is appended to the result right
+// away. Only the state for the input after that is kept. For text that is a few hundred
+// positions, binary content can leave the split points of its binary shift sequences open
+// for much longer though, up to the entire input.
+// Bit stuffing happens afterwards, on the complete result.
 BitVector AztecBarcode::aztecEncode(const QByteArray &data) const
 {
-    // phase one: translate single and double chars to code points
-    std::vector<aztec_code_t> codes;
-    codes.reserve(data.size());
-    for (int i = 0; i < data.size(); ++i) {
-        const uint8_t c1 = data.at(i);
-        // double char codes
-        if (i < data.size() - 1) {
-            const uint8_t c2 = data.at(i + 1);
-            bool found = false;
-            for (const auto &dblCode : aztec_code_double_symbols) {
-                if (dblCode.c1 != c1 || dblCode.c2 != c2) {
-                    continue;
+    constexpr auto Unreachable = std::numeric_limits<int>::max();
+    constexpr int FlushInterval = 256;
+    const auto size = data.size();
+    const auto input = reinterpret_cast<const uint8_t *>(data.constData());
+
+    // nodes for the input positions from nodesBegin on
+    std::vector<AztecPosition> nodes;
+    nodes.reserve(std::min(size, 4 * FlushInterval) + 1);
+    int nodesBegin = 0;
+    const auto nodesAt = [&](int pos) -> AztecPosition & {
+        return nodes[pos - nodesBegin];
+    };
+    nodes.resize(std::min(size, FlushInterval) + 1);
+    nodes[0].arrivals[Upper].cost = 0;
+
+    static constexpr Mode binaryModes[] = {Upper, Lower, Mixed};
+    AztecWindowMin shortBinary[Mixed + 1];
+    AztecWindowMin longBinary[Mixed + 1];
+
+    const auto relax = [](AztecNode &node, int cost, int from, StepType step, uint8_t mode) {
+        if (cost < node.cost) {
+            node = {cost, from, step, mode};
+        }
+    };
+
+    // the node preceding @p node on its path
+    const auto parent = [&](const AztecNodeRef &node) -> AztecNodeRef {
+        if (node.pos == 0) {
+            return {0, NoMode};
+        }
+        const auto arrivalMode = nodesAt(node.pos).latched[node.mode].mode;
+        return {nodesAt(node.pos).arrivals[arrivalMode].from, arrivalMode};
+    };
+
+    // emit the bit stream
+    BitVector result;
+    result.reserve(6 * size);
+    Mode currentMode = Upper;
+    const auto emit = [&](const AztecStep &step) {
+        switch (step.step) {
+        case NoStep:
+            while (currentMode != step.mode) {
+                currentMode = aztecCodeLatchTo(currentMode, step.mode, &result);
+            }
+            break;
+        case DirectStep:
+            Q_ASSERT(currentMode == step.mode);
+            if (step.to - step.from == 2) {
+                result.appendMSB(aztecDoubleCharCode(input[step.from], input[step.from + 1]), aztec_code_size[currentMode]);
+            } else {
+                result.appendMSB(aztecCharCode(input[step.from], currentMode), aztec_code_size[currentMode]);
+            }
+            break;
+        case ShiftStep:
+            Q_ASSERT(currentMode == step.mode);
+            result.appendMSB(aztec_shift_codes[currentMode][step.shiftMode].code, aztec_code_size[currentMode]);
+            if (step.to - step.from == 2) {
+                result.appendMSB(aztecDoubleCharCode(input[step.from], input[step.from + 1]), aztec_code_size[step.shiftMode]);
+            } else {
+                result.appendMSB(aztecCharCode(input[step.from], step.shiftMode), aztec_code_size[step.shiftMode]);
+            }
+            break;
+        case BinaryStep: {
+            Q_ASSERT(currentMode == step.mode);
+            result.appendMSB(aztec_latch_codes[currentMode][Binary].code, aztec_code_size[currentMode]);
+            const auto length = step.to - step.from;
+            if (length <= BinaryShortLength) {
+                result.appendMSB(length, 5);
+            } else {
+                result.appendMSB(0, 5);
+                result.appendMSB(length - BinaryShortLength, 11);
+            }
+            aztecAppendBinary(input + step.from, length, &result);
+            break;
+        }
+        }
+    };
+
+    // nodes of a path in reverse order, ending with the last written node
+    AztecNodeRef written = {0, NoMode};
+    std::vector<AztecNodeRef> path;
+    const auto tracePath = [&](AztecNodeRef node) {
+        path.clear();
+        for (; !(node == written); node = parent(node)) {
+            path.push_back(node);
+        }
+        path.push_back(written);
+    };
+    // writes the path up to path[end]
+    const auto writePath = [&](int end) {
+        for (auto i = int(path.size()) - 2; i >= end; --i) {
+            const auto &node = path[i];
+            if (node.pos > 0) {
+                const auto arrivalMode = path[i + 1].mode;
+                const auto &arrival = nodesAt(node.pos).arrivals[arrivalMode];
+                emit({arrival.from, node.pos, arrival.step, static_cast<Mode>(arrivalMode), static_cast<Mode>(arrival.mode)});
+            }
+            emit({node.pos, node.pos, NoStep, static_cast<Mode>(node.mode), NoMode});
+        }
+        written = path[end];
+    };
+
+    // finds the last node all paths through @p open have in common, and writes the path up to there
+    int visit = 0;
+    const auto flush = [&](const std::vector<AztecNodeRef> &open) {
+        ++visit;
+        // all nodes on the path of the first open node are junctions with that path themselves
+        tracePath(open.front());
+        for (int i = 0; i < int(path.size()) - 1; ++i) {
+            auto &latched = nodesAt(path[i].pos).latched[path[i].mode];
+            latched.visited = visit;
+            latched.junction = i;
+        }
+
+        // follow the other paths until they meet an already visited one, the junction closest
+        // to the start of the input is where all paths have merged
+        int common = 0;
+        for (auto it = std::next(open.begin()); it != open.end() && common + 1 < int(path.size()); ++it) {
+            auto node = *it;
+            int junction = int(path.size()) - 1;
+            for (; !(node == written); node = parent(node)) {
+                const auto &latched = nodesAt(node.pos).latched[node.mode];
+                if (latched.visited == visit) {
+                    junction = latched.junction;
+                    break;
                 }
-                codes.push_back(dblCode.sym);
-                ++i;
-                found = true;
             }
-            if (found) {
-                continue;
+            for (auto n = *it; !(n == node); n = parent(n)) {
+                auto &latched = nodesAt(n.pos).latched[n.mode];
+                latched.visited = visit;
+                latched.junction = junction;
             }
+            common = std::max(common, junction);
         }
+        if (common + 1 == int(path.size())) {
+            return;
+        }
+        writePath(common);
 
-        // > 127 binary-only range
-        if (c1 > 127) {
-            codes.push_back({c1, Binary});
-            // encodable single ASCII character
-        } else {
-            codes.push_back(aztec_code_table[c1]);
+        // the input before the written part is not needed anymore
+        if (written.pos - nodesBegin > int(nodes.size()) / 2) {
+            nodes.erase(nodes.begin(), nodes.begin() + (written.pos - nodesBegin));
+            nodesBegin = written.pos;
         }
-    }
+    };
+    std::vector<AztecNodeRef> open;
+    int nextFlush = FlushInterval;
 
-    // phase two: insert shift and latch codes, translate to bit stream
-    Mode currentMode = Upper;
-    BitVector result;
-    for (auto it = codes.begin(); it != codes.end();) {
-        if ((*it).mode == Binary) {
-            auto newMode = aztecCodeLatchTo(currentMode, Binary, &result);
-            while (newMode != Binary) {
-                currentMode = newMode;
-                newMode = aztecCodeLatchTo(currentMode, Binary, &result);
+    for (int i = 0; i <= size; ++i) {
+        if (int(nodes.size()) + nodesBegin < std::min(i + 3, size + 1)) {
+            nodes.resize(std::min(i + 3 + FlushInterval, size + 1) - nodesBegin);
+        }
+        // nodes for the following positions are stored right after this one
+        const auto position = &nodesAt(i);
+        auto &arrivals = position->arrivals;
+        auto &latched = position->latched;
+
+        // binary shift sequences ending here
+        for (const auto mode : binaryModes) {
+            auto &shortWindow = shortBinary[mode];
+            shortWindow.popBefore(i - BinaryShortLength);
+            if (!shortWindow.isEmpty()) {
+                const auto &m = shortWindow.min();
+                relax(arrivals[mode], m.second + 8 * i + aztec_code_size[mode] + 5, m.first, BinaryStep, mode);
+            }
+            auto &longWindow = longBinary[mode];
+            if (i > BinaryShortLength) {
+                const auto from = i - BinaryShortLength - 1;
+                const auto cost = nodesAt(from).latched[mode].cost;
+                if (cost != Unreachable) {
+                    longWindow.push(from, cost - 8 * from);
+                }
+            }
+            longWindow.popBefore(i - BinaryMaxLength);
+            if (!longWindow.isEmpty()) {
+                const auto &m = longWindow.min();
+                relax(arrivals[mode], m.second + 8 * i + aztec_code_size[mode] + 16, m.first, BinaryStep, mode);
             }
-            aztecEncodeBinary(it, codes.end(), &result);
-            continue;
         }
-        // resolve special codes
-        if ((*it).mode == Special) {
-            aztecEncodeResolveAmbigious(currentMode, it, codes.end());
+
+        // latches, staying in the current mode takes precedence
+        for (int mode = Upper; mode <= Digit; ++mode) {
+            latched[mode].cost = arrivals[mode].cost;
+            latched[mode].mode = mode;
+        }
+        for (int fromMode = Upper; fromMode <= Digit; ++fromMode) {
+            const auto cost = arrivals[fromMode].cost;
+            if (cost == Unreachable) {
+                continue;
+            }
+            for (int mode = Upper; mode <= Digit; ++mode) {
+                const auto latchCost = cost + aztec_encoding_tables.latchCost[fromMode][mode];
+                if (latchCost < latched[mode].cost) {
+                    latched[mode].cost = latchCost;
+                    latched[mode].mode = fromMode;
+                }
+            }
+        }
+        if (i == size) {
+            break;
         }
 
-        // deal with mode changes
-        Mode nextMode = currentMode;
-        if ((*it).mode != currentMode) {
-            bool tryShift = false;
-            const auto newMode = aztecNextMode(currentMode, it, codes.end(), tryShift);
+        const auto &entry = aztec_encoding_tables.chars[input[i]];
+        const auto hasDoubleChar = i + 1 < size && entry.doubleCharCode >= 0 && entry.doubleCharSecond == input[i + 1];
+        for (int m = Upper; m <= Digit; ++m) {
+            const auto mode = static_cast<Mode>(m);
+            const auto cost = latched[mode].cost;
+            if (cost == Unreachable) {
+                continue;
+            }
+            const auto modeSize = aztec_code_size[mode];
+
+            // single characters, directly or via shift
+            if (entry.code[mode] >= 0) {
+                relax(position[1].arrivals[mode], cost + modeSize, i, DirectStep, mode);
+            }
+            for (const auto shiftMode : {Upper, Punct}) {
+                if (entry.code[shiftMode] >= 0 && aztec_shift_codes[mode][shiftMode].mode != NoMode) {
+                    relax(position[1].arrivals[mode], cost + modeSize + aztec_code_size[shiftMode], i, ShiftStep, shiftMode);
+                }
+            }
 
-            // shift to new mode if desired and possible
-            if (tryShift && aztec_shift_codes[currentMode][newMode].mode != NoMode) {
-                qCDebug(Log) << "shift" << aztec_shift_codes[currentMode][newMode].code << aztec_code_size[currentMode];
-                result.appendMSB(aztec_shift_codes[currentMode][newMode].code, aztec_code_size[currentMode]);
-                currentMode = newMode;
+            // double characters in Punct
+            if (hasDoubleChar) {
+                if (mode == Punct) {
+                    relax(position[2].arrivals[mode], cost + modeSize, i, DirectStep, mode);
+                } else if (aztec_shift_codes[mode][Punct].mode != NoMode) {
+                    relax(position[2].arrivals[mode], cost + modeSize + aztec_code_size[Punct], i, ShiftStep, Punct);
+                }
             }
 
-            // latch to new mode
-            while (currentMode != newMode && newMode != NoMode && currentMode != NoMode) {
-                currentMode = aztecCodeLatchTo(currentMode, newMode, &result);
-                nextMode = currentMode;
+            // start of binary shift sequences
+            if (mode <= Mixed) {
+                shortBinary[mode].push(i, cost - 8 * i);
             }
         }
 
-        qCDebug(Log) << (*it).code << aztec_code_size[currentMode];
-        result.appendMSB((*it).code, aztec_code_size[currentMode]);
-        ++it;
+        // all nodes later steps can start from: single and double characters from the last two
+        // positions, binary shift sequences from the windows or positions not yet added to those
+        if (i == nextFlush) {
+            open.clear();
+            for (int pos = i; pos >= std::max(i - BinaryShortLength, nodesBegin); --pos) {
+                for (int mode = Upper; mode <= (pos + 1 < i ? int(Mixed) : int(Digit)); ++mode) {
+                    if (nodesAt(pos).latched[mode].cost != Unreachable) {
+                        open.push_back({pos, mode});
+                    }
+                }
+            }
+            for (const auto mode : binaryModes) {
+                longBinary[mode].forEach([&](int pos) {
+                    open.push_back({pos, mode});
+                });
+            }
+            flush(open);
+            // a flush costs up to the length of the open part, so flushing at most that often keeps this linear
+            nextFlush = i + std::max(FlushInterval, i - written.pos);
+        }
+    }
 
-        currentMode = nextMode;
+    // write the remaining part of the shortest path
+    Mode mode = Upper;
+    for (int m = Upper; m <= Digit; ++m) {
+        if (nodesAt(size).latched[m].cost < nodesAt(size).latched[mode].cost) {
+            mode = static_cast<Mode>(m);
+        }
     }
+    tracePath({size, mode});
+    writePath(0);
+    Q_ASSERT(result.size() == nodesAt(size).latched[mode].cost);
 
     return result;
 }
@@ -473,22 +868,21 @@ BitVector AztecBarcode::bitStuffAndPad(const BitVector &input, int codeWordSize)
     res.reserve(input.size());
 
     // bit stuff codewords with leading codeWordSize 0/1 bits
-    int i = 0;
-    while (i < input.size() - (codeWordSize - 1)) {
-        int v = input.valueAtMSB(i, codeWordSize - 1);
+    const auto allOnes = (1 << (codeWordSize - 1)) - 1;
+    auto reader = BitVectorView(input).reader();
+    while (reader.remaining() > codeWordSize - 1) {
+        const auto v = int(reader.read(codeWordSize - 1));
         res.appendMSB(v, codeWordSize - 1);
-        i += codeWordSize - 1;
         if (v == 0) {
             res.appendBit(true);
-        } else if (v == (1 << (codeWordSize - 1)) - 1) {
+        } else if (v == allOnes) {
             res.appendBit(false);
         } else {
-            res.appendBit(input.at(i++));
+            res.appendBit(reader.readBit());
         }
     }
-    while (i < input.size()) {
-        res.appendBit(input.at(i++));
-    }
+    const auto tail = reader.remaining();
+    res.appendMSB(reader.read(tail), tail);
 
     // check if we are code word aligned already
     const auto trailingBits = res.size() % codeWordSize;
@@ -498,67 +892,46 @@ BitVector AztecBarcode::bitStuffAndPad(const BitVector &input, int codeWordSize)
 
     // pad with ones to nearest code word boundary
     // last bit has to be zero if we'd otherwise would have all ones though
-    bool allOnes = true;
-    for (int i = res.size() - trailingBits; i < res.size(); ++i) {
-        allOnes &= res.at(i);
-    }
-    while (res.size() % codeWordSize) {
-        if ((res.size() % codeWordSize) == (codeWordSize - 1)) {
-            res.appendBit(allOnes ? false : true);
-        } else {
-            res.appendBit(true);
-        }
-    }
+    const auto trailingAllOnes = res.valueAtMSB(res.size() - trailingBits, trailingBits) == (1 << trailingBits) - 1;
+    const auto padBits = codeWordSize - trailingBits;
+    res.appendMSB(((1 << padBits) - 1) & ~(trailingAllOnes ? 1 : 0), padBits);
 
     return res;
 }
 
-void AztecBarcode::paintFullGrid(QImage *img) const
-{
-    QPainter p(img);
-    p.translate(img->width() / 2, img->height() / 2);
+// module position relative to the symbol center
+struct aztec_module_pos_t {
+    int8_t x;
+    int8_t y;
+};
 
-    // alignment grids
-    QPen pen(foregroundColor());
-    pen.setDashPattern({1, 1});
-    p.setPen(pen);
-    for (int i = 0; i < img->width() / 2; i += FullGridInterval) {
-        p.drawLine(-i, -FullRadius, -i, FullRadius);
-        p.drawLine(i, -FullRadius, i, FullRadius);
-        p.drawLine(-FullRadius, -i, FullRadius, -i);
-        p.drawLine(-FullRadius, i, FullRadius, i);
+// rotates a module position around the center by @p quarterTurns * 90° clockwise
+static constexpr aztec_module_pos_t aztecRotate(int x, int y, int quarterTurns)
+{
+    for (; quarterTurns > 0; --quarterTurns) {
+        const auto t = x;
+        x = -y;
+        y = t;
     }
-
-    // bullseye background
-    p.setBrush(backgroundColor());
-    p.setPen(Qt::NoPen);
-    p.drawRect(-7, -7, 14, 14);
-
-    // bullseye
-    p.setBrush(Qt::NoBrush);
-    p.setPen(foregroundColor());
-    p.drawPoint(0, 0);
-    p.drawRect(-2, -2, 4, 4);
-    p.drawRect(-4, -4, 8, 8);
-    p.drawRect(-6, -6, 12, 12);
-
-    // bullseye orientation marker
-    p.drawRect(-7, -7, 1, 1);
-    p.drawRect(7, -7, 0, 1);
-    p.drawPoint(7, 6);
+    return {int8_t(x), int8_t(y)};
 }
 
-static const int aztecFullLayerOffset[] = {
-    //   0   1   2   3   4   5   6   7   8   9  10  11  12  13  14  15  16  17  18  19  20  21  22  23  24  25  26 27 28 29 30 31
-    66, 64, 62, 60, 57, 55, 53, 51, 49, 47, 45, 42, 40, 38, 36, 34, 32, 30, 28, 25, 23, 21, 19, 17, 15, 13, 10, 8, 6, 4, 2, 0};
+// module positions of all data and mode message bits, in placement order.
+// Layers are filled from the outside in, so the data positions for a smaller layer count
+// are the tail of those for the maximum layer count. These are built once on first use,
+// the full table is too large for compile-time evaluation on all compilers.
+template<int DataBits, int ModeMessageSize>
+struct aztec_placement_t {
+    aztec_module_pos_t data[DataBits] = {};
+    aztec_module_pos_t modeMessage[ModeMessageSize] = {};
+};
 
-void AztecBarcode::paintFullData(QImage *img, const BitVector &data, int layerCount) const
+using aztec_full_placement_t = aztec_placement_t<aztecFullDataBits(FullLayerCount), FullModeMessageSize>;
+static aztec_full_placement_t aztecBuildFullPlacement()
 {
-    QPainter p(img);
-    p.setPen(foregroundColor());
-
-    auto it = data.begin();
-    for (int layer = layerCount - 1; layer >= 0; --layer) {
+    aztec_full_placement_t placement;
+    int it = 0;
+    for (int layer = FullLayerCount - 1; layer >= 0; --layer) {
         const auto x1 = aztecFullLayerOffset[layer];
         const auto y1 = x1;
         const auto gridInMiddle = (x1 - FullRadius) % FullGridInterval == 0;
@@ -566,12 +939,7 @@ void AztecBarcode::paintFullData(QImage *img, const BitVector &data, int layerCo
         const auto segmentLength = FullMaxSize - 2 * y1 - 2 - (gridInMiddle ? 1 : 0);
 
         for (int rotation = 0; rotation < 4; ++rotation) {
-            p.resetTransform();
-            p.translate(img->width() / 2, img->height() / 2);
-            p.rotate(-90 * rotation);
-            p.translate(-img->width() / 2, -img->height() / 2);
-
-            for (int i = 0; it != data.end(); ++i, ++it) {
+            for (int i = 0;; ++i) {
                 const auto x = (i % 2 == 0) ? x1 : x2;
                 auto y = i / 2 + y1;
                 if (((y - FullRadius - 1) % FullGridInterval) == 0) { // skip grid lines
@@ -581,134 +949,215 @@ void AztecBarcode::paintFullData(QImage *img, const BitVector &data, int layerCo
                 if (y >= y1 + segmentLength) {
                     break;
                 }
-                if (*it) {
-                    p.drawPoint(x, y);
-                }
+                placement.data[it++] = aztecRotate(x - FullMaxSize / 2, y - FullMaxSize / 2, (4 - rotation) % 4);
             }
         }
     }
+
+    it = 0;
+    for (int rotation = 0; rotation < 4; ++rotation) {
+        for (int i = -5; i <= 5; ++i) {
+            if (i != 0) { // skip grid line
+                placement.modeMessage[it++] = aztecRotate(i, -7, rotation);
+            }
+        }
+    }
+    return placement;
+}
+static const aztec_full_placement_t &aztecFullPlacement()
+{
+    static const aztec_full_placement_t placement = aztecBuildFullPlacement();
+    return placement;
 }
 
-void AztecBarcode::paintFullModeMessage(QImage *img, const BitVector &modeData) const
+using aztec_compact_placement_t = aztec_placement_t<aztecCompactDataBits(CompactLayerCount), CompactModeMessageSize>;
+static aztec_compact_placement_t aztecBuildCompactPlacement()
 {
-    Q_ASSERT(modeData.size() == FullModeMessageSize);
+    aztec_compact_placement_t placement;
+    int it = 0;
+    for (int layer = CompactLayerCount - 1; layer >= 0; --layer) {
+        const auto x1 = aztecCompactLayerOffset[layer];
+        const auto y1 = x1;
+        const auto x2 = x1 + 1;
+        const auto segmentLength = CompactMaxSize - 2 * y1 - 2;
 
-    QPainter p(img);
-    p.setPen(foregroundColor());
+        for (int rotation = 0; rotation < 4; ++rotation) {
+            for (int i = 0; i / 2 < segmentLength; ++i) {
+                const auto x = (i % 2 == 0) ? x1 : x2;
+                const auto y = i / 2 + y1;
+                placement.data[it++] = aztecRotate(x - CompactMaxSize / 2, y - CompactMaxSize / 2, (4 - rotation) % 4);
+            }
+        }
+    }
 
-    auto it = modeData.begin();
+    it = 0;
     for (int rotation = 0; rotation < 4; ++rotation) {
-        p.resetTransform();
-        p.translate(img->width() / 2, img->height() / 2);
-        p.rotate(90 * rotation);
+        for (int i = -3; i <= 3; ++i) {
+            placement.modeMessage[it++] = aztecRotate(i, -5, rotation);
+        }
+    }
+    return placement;
+}
+static const aztec_compact_placement_t &aztecCompactPlacement()
+{
+    static const aztec_compact_placement_t placement = aztecBuildCompactPlacement();
+    return placement;
+}
 
-        for (int i = -5; i <= 5; ++i) {
-            if (i == 0) { // skip grid line
-                continue;
-            }
-            if (*it) {
-                p.drawPoint(i, -7);
+// sets the modules at @p positions for all set bits in @p bits, positions are relative to the center of @p img
+static void aztecPlaceModules(QImage *img, const aztec_module_pos_t *positions, BitVectorView bits)
+{
+    const auto cx = img->width() / 2;
+    const auto cy = img->height() / 2;
+    auto reader = bits.reader();
+    while (!reader.atEnd()) {
+        const auto count = std::min(64, reader.remaining());
+        const auto word = reader.read(count);
+        for (int i = count - 1; i >= 0; --i, ++positions) {
+            if (word & (quint64(1) << i)) {
+                BarcodeMatrixPrivate::setModule(img, cx + positions->x, cy + positions->y);
             }
-            ++it;
         }
     }
 }
 
-QImage AztecBarcode::cropAndScaleFull(QImage *img, int layerCount)
+// reads the modules at @p positions, counterpart to aztecPlaceModules()
+static void aztecReadModules(const QImage &img, const aztec_module_pos_t *positions, int count, BitVector *bits)
 {
-    const auto offset = aztecFullLayerOffset[layerCount - 1];
-    const auto minSize = FullMaxSize - 2 * offset;
-
-    QImage out(minSize, minSize, img->format());
-    QPainter p(&out);
-    p.setRenderHint(QPainter::SmoothPixmapTransform, false);
-    const auto srcRect = img->rect().adjusted(offset, offset, -offset, -offset);
-    p.drawImage(out.rect(), *img, srcRect);
-    return out;
+    const auto cx = img.width() / 2;
+    const auto cy = img.height() / 2;
+    bits->reserve(bits->size() + count);
+    while (count > 0) {
+        const auto n = std::min(64, count);
+        quint64 word = 0;
+        for (int i = 0; i < n; ++i, ++positions) {
+            word = (word << 1) | (BarcodeMatrixPrivate::module(img, cx + positions->x, cy + positions->y) ? 1 : 0);
+        }
+        bits->appendMSB(word, n);
+        count -= n;
+    }
 }
 
-void AztecBarcode::paintCompactGrid(QImage *img) const
+bool AztecBarcode::verifySymbol(const QImage &modules, bool compactMode)
 {
-    QPainter p(img);
-    p.translate(img->width() / 2, img->height() / 2);
-
-    // bullseye
-    p.setPen(foregroundColor());
-    p.drawPoint(0, 0);
-    p.drawRect(-2, -2, 4, 4);
-    p.drawRect(-4, -4, 8, 8);
+    if (modules.width() != modules.height()) {
+        return false;
+    }
+    const auto maxSize = compactMode ? CompactMaxSize : FullMaxSize;
+    const auto layerOffsets = compactMode ? aztecCompactLayerOffset : aztecFullLayerOffset;
+    const auto maxLayerCount = compactMode ? CompactLayerCount : FullLayerCount;
+    const auto layerIt = std::find(layerOffsets, layerOffsets + maxLayerCount, (maxSize - modules.width()) / 2);
+    if (layerIt == layerOffsets + maxLayerCount || maxSize - 2 * (*layerIt) != modules.width()) {
+        return false;
+    }
+    const auto layerCount = int(std::distance(layerOffsets, layerIt)) + 1;
 
-    // bullseye orientation marker
-    p.drawRect(-5, -5, 1, 1);
-    p.drawRect(5, -5, 0, 1);
-    p.drawPoint(5, 4);
+    BitVector modeMsg;
+    BitVector encodedData;
+    if (compactMode) {
+        aztecReadModules(modules, aztecCompactPlacement().modeMessage, CompactModeMessageSize, &modeMsg);
+        const auto dataBits = aztecCompactDataBits(layerCount);
+        aztecReadModules(modules, std::end(aztecCompactPlacement().data) - dataBits, dataBits, &encodedData);
+    } else {
+        aztecReadModules(modules, aztecFullPlacement().modeMessage, FullModeMessageSize, &modeMsg);
+        const auto dataBits = aztecFullDataBits(layerCount);
+        aztecReadModules(modules, std::end(aztecFullPlacement().data) - dataBits, dataBits, &encodedData);
+    }
+    return verifyCodewords(encodedData, modeMsg, compactMode);
 }
 
-static const int aztecCompactLayerOffset[] = {6, 4, 2, 0};
-
-void AztecBarcode::paintCompactData(QImage *img, const BitVector &data, int layerCount) const
+// orientation marks in the ring of radius @p r around the bullseye
+static bool aztecOrientationModule(int dx, int dy, int r)
 {
-    QPainter p(img);
-    p.setPen(foregroundColor());
+    return (dx == -r && dy <= -r + 1) || (dy == -r && dx == -r + 1) || (dx == r && (dy <= -r + 1 || dy == r - 1));
+}
 
-    auto it = data.begin();
-    for (int layer = layerCount - 1; layer >= 0; --layer) {
-        const auto x1 = aztecCompactLayerOffset[layer];
-        const auto y1 = x1;
-        const auto x2 = x1 + 1;
-        const auto segmentLength = CompactMaxSize - 2 * y1 - 2;
+// bullseye, orientation marks and reference grid of full symbols, relative to the center
+static bool aztecFullGridModule(int dx, int dy)
+{
+    const auto dist = std::max(std::abs(dx), std::abs(dy));
+    if (dist < 7) {
+        return dist % 2 == 0;
+    }
+    if (dist == 7) {
+        return aztecOrientationModule(dx, dy, 7);
+    }
+    return (dx % FullGridInterval == 0 || dy % FullGridInterval == 0) && (dx + dy) % 2 == 0;
+}
 
-        for (int rotation = 0; rotation < 4; ++rotation) {
-            p.resetTransform();
-            p.translate(img->width() / 2, img->height() / 2);
-            p.rotate(-90 * rotation);
-            p.translate(-img->width() / 2, -img->height() / 2);
+// bullseye and orientation marks of compact symbols, relative to the center
+static bool aztecCompactGridModule(int dx, int dy)
+{
+    const auto dist = std::max(std::abs(dx), std::abs(dy));
+    if (dist < 5) {
+        return dist % 2 == 0;
+    }
+    return dist == 5 && aztecOrientationModule(dx, dy, 5);
+}
 
-            for (int i = 0; it != data.end(); ++i, ++it) {
-                const auto x = (i % 2 == 0) ? x1 : x2;
-                auto y = i / 2 + y1;
-                if (y >= y1 + segmentLength) {
-                    break;
-                }
-                if (*it) {
-                    p.drawPoint(x, y);
-                }
+// sets all modules of @p img matching @p isGridModule, relative to the image center
+template<typename F>
+static void aztecPaintGrid(QImage *img, F isGridModule)
+{
+    const auto cx = img->width() / 2;
+    const auto cy = img->height() / 2;
+    for (int y = 0; y < img->height(); ++y) {
+        for (int x = 0; x < img->width(); ++x) {
+            if (isGridModule(x - cx, y - cy)) {
+                BarcodeMatrixPrivate::setModule(img, x, y);
             }
         }
     }
 }
 
-void AztecBarcode::paintCompactModeMessage(QImage *img, const BitVector &modeData) const
+const QImage &AztecBarcode::fullTemplate(int layerCount)
 {
-    Q_ASSERT(modeData.size() == CompactModeMessageSize);
+    static const auto templates = [] {
+        std::array<QImage, FullLayerCount> templates;
+        for (int i = 0; i < FullLayerCount; ++i) {
+            const auto size = FullMaxSize - 2 * aztecFullLayerOffset[i];
+            templates[i] = BarcodeMatrixPrivate::createModuleImage(size, size);
+            aztecPaintGrid(&templates[i], aztecFullGridModule);
+        }
+        return templates;
+    }();
+    return templates[layerCount - 1];
+}
 
-    QPainter p(img);
-    p.setPen(foregroundColor());
+void AztecBarcode::paintFullData(QImage *img, const BitVector &data, int layerCount) const
+{
+    const auto dataBits = aztecFullDataBits(layerCount);
+    aztecPlaceModules(img, std::end(aztecFullPlacement().data) - dataBits, BitVectorView(data, 0, std::min(data.size(), dataBits)));
+}
 
-    auto it = modeData.begin();
-    for (int rotation = 0; rotation < 4; ++rotation) {
-        p.resetTransform();
-        p.translate(img->width() / 2, img->height() / 2);
-        p.rotate(90 * rotation);
+void AztecBarcode::paintFullModeMessage(QImage *img, const BitVector &modeData) const
+{
+    Q_ASSERT(modeData.size() == FullModeMessageSize);
+    aztecPlaceModules(img, aztecFullPlacement().modeMessage, modeData);
+}
 
-        for (int i = -3; i <= 3; ++i) {
-            if (*it) {
-                p.drawPoint(i, -5);
-            }
-            ++it;
+const QImage &AztecBarcode::compactTemplate(int layerCount)
+{
+    static const auto templates = [] {
+        std::array<QImage, CompactLayerCount> templates;
+        for (int i = 0; i < CompactLayerCount; ++i) {
+            const auto size = CompactMaxSize - 2 * aztecCompactLayerOffset[i];
+            templates[i] = BarcodeMatrixPrivate::createModuleImage(size, size);
+            aztecPaintGrid(&templates[i], aztecCompactGridModule);
         }
-    }
+        return templates;
+    }();
+    return templates[layerCount - 1];
 }
 
-QImage AztecBarcode::cropAndScaleCompact(QImage *img, int layerCount)
+void AztecBarcode::paintCompactData(QImage *img, const BitVector &data, int layerCount) const
 {
-    const auto offset = aztecCompactLayerOffset[layerCount - 1];
-    const auto minSize = CompactMaxSize - 2 * offset;
+    const auto dataBits = aztecCompactDataBits(layerCount);
+    aztecPlaceModules(img, std::end(aztecCompactPlacement().data) - dataBits, BitVectorView(data, 0, std::min(data.size(), dataBits)));
+}
 
-    QImage out(minSize, minSize, img->format());
-    QPainter p(&out);
-    p.setRenderHint(QPainter::SmoothPixmapTransform, false);
-    const auto srcRect = img->rect().adjusted(offset, offset, -offset, -offset);
-    p.drawImage(out.rect(), *img, srcRect);
-    return out;
+void AztecBarcode::paintCompactModeMessage(QImage *img, const BitVector &modeData) const
+{
+    Q_ASSERT(modeData.size() == CompactModeMessageSize);
+    aztecPlaceModules(img, aztecCompactPlacement().modeMessage, modeData);
 }
@@ -8,6 +8,7 @@
 #define PRISON_AZTECBARCODE_H
 
 #include "abstractbarcode.h"
+#include "prison.h"
 
 class AztecBarcodeTest;
 
@@ -22,6 +23,8 @@ public:
     AztecBarcode();
     ~AztecBarcode() override;
 
+    SymbolInfo symbolInfo() const;
+
 protected:
     QImage paintImage(const QSizeF &size) override;
 
@@ -30,16 +33,28 @@ private:
 
     BitVector aztecEncode(const QByteArray &data) const;
     BitVector bitStuffAndPad(const BitVector &input, int codeWordSize) const;
+    bool selectLayout(const BitVector &inputData, int *layerCount, bool *compactMode, BitVector *stuffedData) const;
+    bool encodeSymbol(BitVector *encodedData, BitVector *modeMsg, int *layerCount, bool *compactMode) const;
+    /** Checks the error correction of the data and mode message code words of a symbol,
+     *  without rendering and decoding it. Returns @c true if no errors are found.
+     */
+    static bool verifyCodewords(const BitVector &encodedData, const BitVector &modeMsg, bool compactMode);
+    /** Reads back the data and mode message bits from the module image of a symbol,
+     *  and checks their error correction like verifyCodewords().
+     */
+    static bool verifySymbol(const QImage &modules, bool compactMode);
+
+    /** Module images of full and compact symbols with @p layerCount layers, containing
+     *  only the bullseye, orientation marks and reference grid.
+     */
+    static const QImage &fullTemplate(int layerCount);
+    static const QImage &compactTemplate(int layerCount);
 
-    void paintFullGrid(QImage *img) const;
     void paintFullData(QImage *img, const BitVector &data, int layerCount) const;
     void paintFullModeMessage(QImage *img, const BitVector &modeData) const;
-    QImage cropAndScaleFull(QImage *img, int layerCount);
 
-    void paintCompactGrid(QImage *img) const;
     void paintCompactData(QImage *img, const BitVector &data, int layerCount) const;
     void paintCompactModeMessage(QImage *img, const BitVector &modeData) const;
-    QImage cropAndScaleCompact(QImage *img, int layerCount);
 };
 
 }
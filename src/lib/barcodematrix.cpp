@@ -0,0 +1,125 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: MIT
+*/
+
+#include "barcodematrix.h"
+#include "barcodematrix_p.h"
+
+#include <cstring>
+
+using namespace Prison;
+
+BarcodeMatrix::BarcodeMatrix() = default;
+BarcodeMatrix::BarcodeMatrix(BarcodeMatrixPrivate *dd)
+    : d(dd)
+{
+}
+
+BarcodeMatrix::BarcodeMatrix(const BarcodeMatrix &) = default;
+BarcodeMatrix::BarcodeMatrix(BarcodeMatrix &&) noexcept = default;
+BarcodeMatrix::~BarcodeMatrix() = default;
+BarcodeMatrix &BarcodeMatrix::operator=(const BarcodeMatrix &) = default;
+BarcodeMatrix &BarcodeMatrix::operator=(BarcodeMatrix &&) noexcept = default;
+
+bool BarcodeMatrix::operator==(const BarcodeMatrix &other) const
+{
+    if (d == other.d) {
+        return true;
+    }
+    if (size() != other.size()) {
+        return false;
+    }
+    // compare row by row, the alignment padding at the end of each row is undefined
+    const auto fullBytes = width() / 8;
+    const uchar tailMask = ~(0xff >> (width() % 8));
+    for (int y = 0; y < height(); ++y) {
+        const auto l1 = constScanLine(y);
+        const auto l2 = other.constScanLine(y);
+        if (memcmp(l1, l2, fullBytes) != 0 || (tailMask && (l1[fullBytes] & tailMask) != (l2[fullBytes] & tailMask))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BarcodeMatrix::operator!=(const BarcodeMatrix &other) const
+{
+    return !(*this == other);
+}
+
+bool BarcodeMatrix::isNull() const
+{
+    return !d || d->image.isNull();
+}
+
+int BarcodeMatrix::width() const
+{
+    return d ? d->image.width() : 0;
+}
+
+int BarcodeMatrix::height() const
+{
+    return d ? d->image.height() : 0;
+}
+
+QSize BarcodeMatrix::size() const
+{
+    return QSize(width(), height());
+}
+
+bool BarcodeMatrix::module(int x, int y) const
+{
+    Q_ASSERT(x >= 0 && x < width() && y >= 0 && y < height());
+    return constScanLine(y)[x >> 3] & (0x80 >> (x & 7));
+}
+
+const uchar *BarcodeMatrix::constScanLine(int y) const
+{
+    return d ? d->image.constScanLine(y) : nullptr;
+}
+
+int BarcodeMatrix::bytesPerLine() const
+{
+    return d ? d->image.bytesPerLine() : 0;
+}
+
+QImage BarcodeMatrixPrivate::createModuleImage(int width, int height)
+{
+    QImage img(width, height, QImage::Format_Mono);
+    img.setColorTable({qRgb(0xff, 0xff, 0xff), qRgb(0, 0, 0)});
+    img.fill(0);
+    return img;
+}
+
+QImage BarcodeMatrixPrivate::toModuleImage(const QImage &img, QRgb background)
+{
+    if (img.isNull()) {
+        return {};
+    }
+
+    const auto src = img.convertToFormat(QImage::Format_ARGB32);
+    auto modules = createModuleImage(src.width(), src.height());
+    for (int y = 0; y < src.height(); ++y) {
+        const auto line = reinterpret_cast<const QRgb *>(src.constScanLine(y));
+        for (int x = 0; x < src.width(); ++x) {
+            if (line[x] != background) {
+                setModule(&modules, x, y);
+            }
+        }
+    }
+    return modules;
+}
+
+BarcodeMatrix BarcodeMatrixPrivate::fromModuleImage(const QImage &img)
+{
+    if (img.isNull()) {
+        return {};
+    }
+    Q_ASSERT(img.format() == QImage::Format_Mono);
+
+    auto d = new BarcodeMatrixPrivate;
+    d->image = img;
+    return BarcodeMatrix(d);
+}
@@ -0,0 +1,84 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: MIT
+*/
+
+#ifndef PRISON_BARCODEMATRIX_H
+#define PRISON_BARCODEMATRIX_H
+
+#include "prison_export.h"
+
+#include <QExplicitlySharedDataPointer>
+#include <QMetaType>
+#include <QSize>
+
+namespace Prison
+{
+
+class BarcodeMatrixPrivate;
+
+/** The module grid of an encoded barcode.
+ *
+ *  This contains one bit per module (ie. the smallest element of a barcode),
+ *  independent of any output size or color. Set modules are the dark parts of the
+ *  barcode (bars or dots), unset modules are part of the background. The quiet
+ *  zone around the barcode mandated by the respective symbology is included.
+ *
+ *  One-dimensional barcodes are represented by a matrix with a single row.
+ *
+ *  Barcode matrices are immutable and implicitly shared, so they can be
+ *  passed around and accessed from multiple threads cheaply.
+ *
+ *  @see AbstractBarcode::matrix()
+ *  @since 5.104
+ */
+class PRISON_EXPORT BarcodeMatrix
+{
+public:
+    /** Creates a null matrix. */
+    BarcodeMatrix();
+    BarcodeMatrix(const BarcodeMatrix &);
+    BarcodeMatrix(BarcodeMatrix &&) noexcept;
+    ~BarcodeMatrix();
+    BarcodeMatrix &operator=(const BarcodeMatrix &);
+    BarcodeMatrix &operator=(BarcodeMatrix &&) noexcept;
+
+    bool operator==(const BarcodeMatrix &other) const;
+    bool operator!=(const BarcodeMatrix &other) const;
+
+    /** Returns @c true if this matrix does not contain any modules,
+     *  e.g. because the encoded data did not fit into the barcode.
+     */
+    bool isNull() const;
+
+    /** Width of the barcode in modules. */
+    int width() const;
+    /** Height of the barcode in modules. */
+    int height() const;
+    /** Size of the barcode in modules. */
+    QSize size() const;
+
+    /** Returns @c true if the module at position @p x, @p y is set. */
+    bool module(int x, int y) const;
+
+    /** Returns a pointer to the bit-packed modules of row @p y.
+     *  Modules are stored with the most significant bit first, that is
+     *  the module at @p x is bit @c 7 - (x % 8) of byte x / 8.
+     *  This matches the pixel layout of QImage::Format_Mono.
+     */
+    const uchar *constScanLine(int y) const;
+    /** Amount of bytes per row, including any alignment padding at the end of a row. */
+    int bytesPerLine() const;
+
+private:
+    friend class BarcodeMatrixPrivate;
+    explicit BarcodeMatrix(BarcodeMatrixPrivate *dd);
+    QExplicitlySharedDataPointer<BarcodeMatrixPrivate> d;
+};
+
+}
+
+Q_DECLARE_METATYPE(Prison::BarcodeMatrix)
+
+#endif // PRISON_BARCODEMATRIX_H
@@ -0,0 +1,53 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: MIT
+*/
+
+#ifndef PRISON_BARCODEMATRIX_P_H
+#define PRISON_BARCODEMATRIX_P_H
+
+#include "barcodematrix.h"
+
+#include <QImage>
+#include <QSharedData>
+
+namespace Prison
+{
+
+/** Module images are QImage::Format_Mono images where color index 1 marks a set module. */
+class BarcodeMatrixPrivate : public QSharedData
+{
+public:
+    static inline const BarcodeMatrixPrivate *get(const BarcodeMatrix &q)
+    {
+        return q.d.data();
+    }
+
+    /** Creates a module image of the given size with all modules unset. */
+    static QImage createModuleImage(int width, int height);
+    /** Sets the module at @p x, @p y in a module image created by createModuleImage(). */
+    static inline void setModule(QImage *img, int x, int y)
+    {
+        img->scanLine(y)[x >> 3] |= 0x80 >> (x & 7);
+    }
+    /** Returns @c true if the module at @p x, @p y in a module image is set. */
+    static inline bool module(const QImage &img, int x, int y)
+    {
+        return img.constScanLine(y)[x >> 3] & (0x80 >> (x & 7));
+    }
+
+    /** Derives a module image from an already colorized barcode image.
+     *  Every pixel not matching @p background is considered a set module.
+     */
+    static QImage toModuleImage(const QImage &img, QRgb background);
+
+    /** Wraps a module image, without copying. */
+    static BarcodeMatrix fromModuleImage(const QImage &img);
+
+    QImage image;
+};
+
+}
+
+#endif // PRISON_BARCODEMATRIX_P_H
@@ -6,49 +6,81 @@
 
 #include "bitvector_p.h"
 
+#include <QtEndian>
+
 using namespace Prison;
 
 BitVector::BitVector() = default;
 BitVector::~BitVector() = default;
 
-void BitVector::appendLSB(int data, int bits)
+static inline quint64 reverseBits(quint64 v)
+{
+    v = ((v >> 1) & 0x5555555555555555ull) | ((v & 0x5555555555555555ull) << 1);
+    v = ((v >> 2) & 0x3333333333333333ull) | ((v & 0x3333333333333333ull) << 2);
+    v = ((v >> 4) & 0x0f0f0f0f0f0f0f0full) | ((v & 0x0f0f0f0f0f0f0f0full) << 4);
+    return qbswap(v);
+}
+
+void BitVector::appendLSB(quint64 data, int bits)
 {
-    for (int i = 0; i < bits; ++i) {
-        appendBit(data & (1 << i));
+    if (bits <= 0) {
+        return;
     }
+    appendMSB(reverseBits(data) >> (64 - bits), bits);
 }
 
-void BitVector::appendMSB(int data, int bits)
+void BitVector::appendMSB(quint64 data, int bits)
 {
-    for (int i = bits - 1; i >= 0; --i) {
-        appendBit(data & (1 << i));
+    if (bits <= 0) {
+        return;
+    }
+    Q_ASSERT(bits <= 64);
+    if (bits < 64) {
+        data &= (quint64(1) << bits) - 1;
+    }
+
+    const auto used = m_size & 63;
+    if (used == 0) {
+        m_data.push_back(data << (64 - bits));
+    } else {
+        const auto free = 64 - used;
+        if (bits <= free) {
+            m_data.last() |= data << (free - bits);
+        } else {
+            m_data.last() |= data >> (bits - free);
+            m_data.push_back(data << (64 - (bits - free)));
+        }
     }
+    m_size += bits;
 }
 
 void BitVector::appendBit(bool bit)
 {
-    const auto subIdx = m_size % 8;
-    if (subIdx == 0) {
-        m_data.append('\0');
+    if ((m_size & 63) == 0) {
+        m_data.push_back(0);
     }
     if (bit) {
-        m_data.data()[m_data.size() - 1] |= (1 << subIdx);
+        m_data.last() |= quint64(1) << (63 - (m_size & 63));
     }
     ++m_size;
 }
 
 void BitVector::append(const BitVector &other)
 {
-    for (int i = 0; i < other.size(); ++i) {
-        appendBit(other.at(i));
+    if ((m_size & 63) == 0) {
+        // word aligned, the words can be taken over as-is
+        m_data.append(other.m_data.constData(), other.m_data.size());
+        m_size += other.m_size;
+        return;
     }
-}
 
-bool BitVector::at(int index) const
-{
-    const auto majIdx = index / 8;
-    const auto minIdx = index % 8;
-    return (m_data.at(majIdx) & (1 << minIdx)) >> minIdx;
+    const auto fullWords = other.m_size / 64;
+    for (int i = 0; i < fullWords; ++i) {
+        appendMSB(other.m_data[i], 64);
+    }
+    if (const auto tail = other.m_size & 63) {
+        appendMSB(other.m_data[fullWords] >> (64 - tail), tail);
+    }
 }
 
 void BitVector::clear()
@@ -59,7 +91,7 @@ void BitVector::clear()
 
 void BitVector::reserve(int size)
 {
-    m_data.reserve((size / 8) + 1);
+    m_data.reserve((size + 63) / 64);
 }
 
 int BitVector::size() const
@@ -67,14 +99,21 @@ int BitVector::size() const
     return m_size;
 }
 
-int BitVector::valueAtMSB(int index, int size) const
+quint64 BitVector::valueAtMSB64(int index, int size) const
 {
-    int res = 0;
-    for (int i = 0; i < size; ++i) {
-        res = res << 1;
-        res |= (at(index + i) ? 1 : 0);
+    if (size <= 0) {
+        return 0;
+    }
+    Q_ASSERT(size <= 64);
+    Q_ASSERT(index >= 0 && index + size <= m_size);
+
+    const auto word = index >> 6;
+    const auto offset = index & 63;
+    auto v = m_data[word] << offset;
+    if (offset + size > 64) {
+        v |= m_data[word + 1] >> (64 - offset);
     }
-    return res;
+    return v >> (64 - size);
 }
 
 BitVector::iterator BitVector::begin() const
@@ -105,6 +144,11 @@ bool BitVector::operator!=(const Prison::BitVector &other) const
 
 QDebug operator<<(QDebug dbg, const Prison::BitVector &v)
 {
-    dbg << v.m_data.toHex();
+    QByteArray bits;
+    bits.reserve(v.size());
+    for (int i = 0; i < v.size(); ++i) {
+        bits.append(v.at(i) ? '1' : '0');
+    }
+    dbg << bits;
     return dbg;
 }
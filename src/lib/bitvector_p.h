@@ -7,8 +7,10 @@
 #ifndef PRISON_BITVECTOR_P_H
 #define PRISON_BITVECTOR_P_H
 
-#include <QByteArray>
 #include <QDebug>
+#include <QVarLengthArray>
+
+#include <algorithm>
 
 namespace Prison
 {
@@ -18,13 +20,20 @@ QDebug operator<<(QDebug dbg, const Prison::BitVector &v);
 
 namespace Prison
 {
-/** Vector for working with a set of bits without byte alignment. */
+/** Vector for working with a set of bits without byte alignment.
+ *  Bits are stored most significant bit first in 64 bit words, so appending
+ *  or extracting values of up to 64 bits only needs a few shift operations.
+ *  Up to InlineBits bits are stored inline, without any heap allocation.
+ */
 class BitVector
 {
 public:
     BitVector();
     ~BitVector();
 
+    /** Vectors up to this size don't allocate memory. This covers mode messages and their error correction. */
+    static constexpr int InlineBits = 256;
+
     class iterator
     {
     public:
@@ -48,19 +57,33 @@ public:
         int m_index;
     };
 
-    /** Append the lowest @p bits of @p data with the least significant bit first. */
-    void appendLSB(int data, int bits);
-    /** Append the lowest @p bits of @p data with the most significant bit first. */
-    void appendMSB(int data, int bits);
+    /** Append the lowest @p bits of @p data with the least significant bit first.
+     *  @p bits can be at most 64.
+     */
+    void appendLSB(quint64 data, int bits);
+    /** Append the lowest @p bits of @p data with the most significant bit first.
+     *  @p bits can be at most 64.
+     */
+    void appendMSB(quint64 data, int bits);
     void appendBit(bool bit);
     void append(const BitVector &other);
     /** Returns the bit at index @p index. */
-    bool at(int index) const;
+    inline bool at(int index) const
+    {
+        return (m_data[index >> 6] >> (63 - (index & 63))) & 1;
+    }
     void clear();
     void reserve(int size);
     int size() const;
-    /** Returns the value starting at @p index of size @p size. */
-    int valueAtMSB(int index, int size) const;
+    /** Returns the value starting at @p index of size @p size.
+     *  @p size can be at most 31 bits, see valueAtMSB64() for larger values.
+     */
+    inline int valueAtMSB(int index, int size) const
+    {
+        return int(valueAtMSB64(index, size));
+    }
+    /** Returns the value starting at @p index of size @p size, for up to 64 bits. */
+    quint64 valueAtMSB64(int index, int size) const;
     iterator begin() const;
     iterator end() const;
 
@@ -69,10 +92,127 @@ public:
 
 private:
     friend QDebug(::operator<<)(QDebug dbg, const Prison::BitVector &v);
-    QByteArray m_data;
+    QVarLengthArray<quint64, InlineBits / 64> m_data; // unused bits in the last word are always 0
+    int m_size = 0;
+};
+
+class BitReader;
+
+/** Read-only view on a range of a BitVector, without copying.
+ *  The view must not outlive the BitVector it refers to.
+ */
+class BitVectorView
+{
+public:
+    /** View on all of @p v. */
+    inline BitVectorView(const BitVector &v)
+        : m_vector(&v)
+        , m_size(v.size())
+    {
+    }
+    /** View on @p size bits of @p v, starting at @p offset. */
+    inline BitVectorView(const BitVector &v, int offset, int size)
+        : m_vector(&v)
+        , m_offset(offset)
+        , m_size(size)
+    {
+        Q_ASSERT(offset >= 0 && size >= 0 && offset + size <= v.size());
+    }
+
+    inline int size() const
+    {
+        return m_size;
+    }
+    inline bool at(int index) const
+    {
+        return m_vector->at(m_offset + index);
+    }
+    /** Returns the value starting at @p index of size @p size, for up to 64 bits. */
+    inline quint64 valueAtMSB64(int index, int size) const
+    {
+        Q_ASSERT(index + size <= m_size);
+        return m_vector->valueAtMSB64(m_offset + index, size);
+    }
+    /** Returns a view on @p size bits of this view, starting at @p offset. */
+    inline BitVectorView mid(int offset, int size) const
+    {
+        Q_ASSERT(offset >= 0 && size >= 0 && offset + size <= m_size);
+        return BitVectorView(*m_vector, m_offset + offset, size);
+    }
+    inline BitReader reader() const;
+
+private:
+    const BitVector *m_vector;
+    int m_offset = 0;
     int m_size = 0;
 };
 
+/** Sequential reader for fixed or variable width values from a BitVector.
+ *  Reads are served from a 64 bit buffer, which is refilled a full word at a time.
+ */
+class BitReader
+{
+public:
+    inline explicit BitReader(BitVectorView view)
+        : m_view(view)
+    {
+    }
+
+    /** Number of bits that have not been read yet. */
+    inline int remaining() const
+    {
+        return m_view.size() - m_position;
+    }
+    inline bool atEnd() const
+    {
+        return m_position >= m_view.size();
+    }
+    /** Reads the next @p bits bits as a most significant bit first value.
+     *  @p bits can be at most 64, and must not exceed remaining().
+     */
+    inline quint64 read(int bits)
+    {
+        Q_ASSERT(bits >= 0 && bits <= 64 && bits <= remaining());
+        if (bits == 0) {
+            return 0;
+        }
+        if (m_bufferSize < bits) {
+            refill();
+        }
+        const auto value = m_buffer >> (64 - bits);
+        m_buffer = bits == 64 ? 0 : m_buffer << bits;
+        m_bufferSize -= bits;
+        m_position += bits;
+        return value;
+    }
+    inline bool readBit()
+    {
+        return read(1);
+    }
+
+private:
+    // fills the buffer to 64 bits, or up to the end of the view
+    inline void refill()
+    {
+        const auto pending = m_position + m_bufferSize;
+        const auto count = std::min(64 - m_bufferSize, m_view.size() - pending);
+        if (count > 0) {
+            m_buffer |= m_view.valueAtMSB64(pending, count) << (64 - m_bufferSize - count);
+            m_bufferSize += count;
+        }
+    }
+
+    BitVectorView m_view;
+    quint64 m_buffer = 0; // the next m_bufferSize bits, most significant bit first
+    int m_bufferSize = 0;
+    int m_position = 0;
+};
+
+BitReader BitVectorView::reader() const
+{
+    return BitReader(*this);
+}
+
 }
 
 #endif // PRISON_BITVECTOR_P_H
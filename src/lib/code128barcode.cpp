@@ -5,11 +5,11 @@
 */
 
 #include "code128barcode.h"
+#include "barcodematrix_p.h"
 #include "bitvector_p.h"
 #include "prison_debug.h"
 
 #include <QImage>
-#include <QPainter>
 
 using namespace Prison;
 
@@ -44,6 +44,14 @@ Code128Barcode::Code128Barcode()
 }
 Code128Barcode::~Code128Barcode() = default;
 
+SymbolInfo Code128Barcode::symbolInfo() const
+{
+    SymbolInfo info;
+    info.fits = true;
+    info.size = QSize(encode(data().isEmpty() ? byteArrayData() : data().toLatin1()).size() + 2 * QuietZone, 1);
+    return info;
+}
+
 QImage Code128Barcode::paintImage(const QSizeF &size)
 {
     Q_UNUSED(size);
@@ -51,12 +59,10 @@ QImage Code128Barcode::paintImage(const QSizeF &size)
     const auto bits = encode(data().isEmpty() ? byteArrayData() : data().toLatin1());
     const auto width = bits.size() + 2 * QuietZone;
 
-    QImage img(width, 1, QImage::Format_ARGB32);
-    img.fill(backgroundColor());
-    QPainter p(&img);
+    auto img = BarcodeMatrixPrivate::createModuleImage(width, 1);
     for (int i = 0; i < bits.size(); ++i) {
         if (bits.at(i)) {
-            img.setPixel(QuietZone + i, 0, foregroundColor().rgb());
+            BarcodeMatrixPrivate::setModule(&img, QuietZone + i, 0);
         }
     }
 
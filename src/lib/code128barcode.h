@@ -8,6 +8,7 @@
 #define PRISON_CODE128BARCODE_H
 
 #include "abstractbarcode.h"
+#include "prison.h"
 
 class Code128BarcodeTest;
 
@@ -24,6 +25,8 @@ public:
     Code128Barcode();
     ~Code128Barcode() override;
 
+    SymbolInfo symbolInfo() const;
+
 protected:
     QImage paintImage(const QSizeF &size) override;
 
@@ -5,6 +5,7 @@
 */
 
 #include "code39barcode.h"
+#include "barcodematrix_p.h"
 #include "barcodeutil.h"
 #include <QChar>
 
@@ -110,6 +111,24 @@ Code39Barcode::Code39Barcode()
 }
 Code39Barcode::~Code39Barcode() = default;
 
+SymbolInfo Code39Barcode::symbolInfo() const
+{
+    // every symbol consists of 3 wide (2 modules) and 6 narrow (1 module) elements, separated by a narrow gap,
+    // with the start/stop guard sequence at both ends and a quiet zone of 10 modules
+    const QString str = data().isEmpty() ? QString::fromLatin1(byteArrayData().constData(), byteArrayData().size()) : data();
+    int symbolCount = 2;
+    for (const auto c : str) {
+        if (!sequenceForChar(c.unicode()).isEmpty()) {
+            ++symbolCount;
+        }
+    }
+
+    SymbolInfo info;
+    info.fits = true;
+    info.size = QSize(symbolCount * 12 + (symbolCount - 1) + 2 * 10, 1);
+    return info;
+}
+
 QImage Code39Barcode::paintImage(const QSizeF &size)
 {
     Q_UNUSED(size);
@@ -152,21 +171,17 @@ QImage Code39Barcode::paintImage(const QSizeF &size)
 
     const int quietZoneWidth = 10 * smallWidth;
 
-    // one line of the result image
-    QVector<QRgb> line;
-    line.reserve(wide * largeWidth + narrow * smallWidth + 2 * quietZoneWidth);
-    line.insert(0, quietZoneWidth, backgroundColor().rgba());
+    // build the module row, alternating between bars and spaces
+    auto img = BarcodeMatrixPrivate::createModuleImage(wide * largeWidth + narrow * smallWidth + 2 * quietZoneWidth, 1);
+    int x = quietZoneWidth;
     for (int i = 0; i < barcode.size(); i++) {
-        const QRgb color = (((i & 1) == 0) ? foregroundColor() : backgroundColor()).rgba(); // alternate between foreground and background color
         const int width = barcode.at(i) ? largeWidth : smallWidth;
-        for (int j = 0; j < width; j++) {
-            line.append(color);
+        if ((i & 1) == 0) {
+            for (int j = 0; j < width; j++) {
+                BarcodeMatrixPrivate::setModule(&img, x + j, 0);
+            }
         }
+        x += width;
     }
-    line.insert(line.size(), quietZoneWidth, backgroundColor().rgba());
-
-    // build the complete barcode
-    QImage ret(line.size(), 1, QImage::Format_ARGB32);
-    memcpy(ret.scanLine(0), line.data(), line.size() * sizeof(QRgb));
-    return ret;
+    return img;
 }
@@ -8,6 +8,7 @@
 #define PRISON_CODE39BARCODE_H
 
 #include "abstractbarcode.h"
+#include "prison.h"
 
 namespace Prison
 {
@@ -23,6 +24,11 @@ public:
     Code39Barcode();
     ~Code39Barcode() override;
 
+    /**
+     * Determines the barcode geometry without rendering it.
+     */
+    SymbolInfo symbolInfo() const;
+
 protected:
     /**
      * This function generates the barcode
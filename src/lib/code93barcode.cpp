@@ -5,6 +5,7 @@
 */
 
 #include "code93barcode.h"
+#include "barcodematrix_p.h"
 #include "barcodeutil.h"
 #include <QChar>
 
@@ -613,6 +614,22 @@ Code93Barcode::Code93Barcode()
 }
 Code93Barcode::~Code93Barcode() = default;
 
+SymbolInfo Code93Barcode::symbolInfo() const
+{
+    // every code is 9 modules wide, there are two checksum codes, the start/stop guard
+    // sequences at both ends, a termination bar and a quiet zone of 10 modules
+    const QString str = data().isEmpty() ? QString::fromLatin1(byteArrayData().constData(), byteArrayData().size()) : data();
+    int codeCount = 4;
+    for (const auto c : str) {
+        codeCount += codesForChar(c.unicode()).size();
+    }
+
+    SymbolInfo info;
+    info.fits = true;
+    info.size = QSize(codeCount * 9 + 1 + 2 * 10, 1);
+    return info;
+}
+
 QImage Code93Barcode::paintImage(const QSizeF &size)
 {
     Q_UNUSED(size);
@@ -647,20 +664,14 @@ QImage Code93Barcode::paintImage(const QSizeF &size)
     const int barWidth = 1;
     const int quietZoneWidth = 10 * barWidth;
 
-    // build one line of the result image
-    QVector<QRgb> line;
-    line.reserve(barWidth * barcode.size() + 2 * quietZoneWidth);
-    line.insert(0, quietZoneWidth, backgroundColor().rgba());
+    // build the module row
+    auto img = BarcodeMatrixPrivate::createModuleImage(barWidth * barcode.size() + 2 * quietZoneWidth, 1);
     for (int i = 0; i < barcode.size(); i++) {
-        const QRgb color = (barcode.at(i) ? foregroundColor() : backgroundColor()).rgba();
-        for (int j = 0; j < barWidth; j++) {
-            line.append(color);
+        if (barcode.at(i)) {
+            for (int j = 0; j < barWidth; j++) {
+                BarcodeMatrixPrivate::setModule(&img, quietZoneWidth + i * barWidth + j, 0);
+            }
         }
     }
-    line.insert(line.size(), quietZoneWidth, backgroundColor().rgba());
-
-    // build the complete barcode
-    QImage ret(line.size(), 1, QImage::Format_ARGB32);
-    memcpy(ret.scanLine(0), line.data(), line.size() * sizeof(QRgb));
-    return ret;
+    return img;
 }
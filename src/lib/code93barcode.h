@@ -8,6 +8,7 @@
 #define PRISON_CODE93BARCODE_H
 
 #include "abstractbarcode.h"
+#include "prison.h"
 
 namespace Prison
 {
@@ -22,6 +23,11 @@ public:
      */
     Code93Barcode();
     ~Code93Barcode() override;
+
+    /**
+     * Determines the barcode geometry without rendering it.
+     */
+    SymbolInfo symbolInfo() const;
     /**
      * This function generates the barcode
      * @return QImage containing a barcode, trying to approximate the requested sizes
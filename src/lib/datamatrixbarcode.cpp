@@ -5,7 +5,10 @@
 */
 
 #include "datamatrixbarcode.h"
+#include "barcodematrix_p.h"
+
 #include <dmtx.h>
+
 using namespace Prison;
 
 DataMatrixBarcode::DataMatrixBarcode()
@@ -34,45 +37,16 @@ QImage DataMatrixBarcode::paintImage(const QSizeF &size)
     }
     Q_ASSERT(enc->image->width == enc->image->height);
 
-    QImage ret;
-
-    if (foregroundColor() == Qt::black && backgroundColor() == Qt::white) {
-        QImage tmp(enc->image->pxl, enc->image->width, enc->image->height, QImage::Format_ARGB32);
-        // we need to copy, because QImage generated from a char pointer requires the
-        // char pointer to be kept around forever, and manually deleted.
-        ret = tmp.copy();
-    } else {
-        if (enc->image->width > 0) {
-            int size = enc->image->width * enc->image->height * 4;
-            uchar *img = new uchar[size];
-            QByteArray background(4, '\0');
-            background[3] = qAlpha(backgroundColor().rgba());
-            background[2] = qRed(backgroundColor().rgba());
-            background[1] = qGreen(backgroundColor().rgba());
-            background[0] = qBlue(backgroundColor().rgba());
-            QByteArray foreground(4, '\0');
-            foreground[3] = qAlpha(foregroundColor().rgba());
-            foreground[2] = qRed(foregroundColor().rgba());
-            foreground[1] = qGreen(foregroundColor().rgba());
-            foreground[0] = qBlue(foregroundColor().rgba());
-            for (int i = 1; i < size; i += 4) {
-                QByteArray color;
-                if (enc->image->pxl[i] == 0x00) {
-                    color = foreground;
-                } else {
-                    color = background;
-                }
-                for (int j = 0; j < 4; j++) {
-                    img[i - 1 + j] = color[j];
-                }
+    // pixels are either black or white, so the green channel is enough to tell them apart
+    const auto width = enc->image->width;
+    auto img = BarcodeMatrixPrivate::createModuleImage(width, enc->image->height);
+    for (int y = 0; y < enc->image->height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (enc->image->pxl[(y * width + x) * 4 + 1] == 0x00) {
+                BarcodeMatrixPrivate::setModule(&img, x, y);
             }
-            QImage tmp(img, enc->image->width, enc->image->height, QImage::Format_ARGB32);
-            // we need to copy, because QImage generated from a char pointer requires the
-            // char pointer to be kept around forever, and manually deleted.
-            ret = tmp.copy();
-            delete[] img;
         }
     }
     dmtxEncodeDestroy(&enc);
-    return ret;
+    return img;
 }
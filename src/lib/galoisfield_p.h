@@ -0,0 +1,107 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: MIT
+*/
+
+#ifndef PRISON_GALOISFIELD_P_H
+#define PRISON_GALOISFIELD_P_H
+
+#include <QtGlobal>
+
+#include <type_traits>
+
+namespace Prison
+{
+
+namespace GaloisFieldUtil
+{
+constexpr int highestBit(int n)
+{
+    int i = 0;
+    while (n >= (1 << i)) {
+        ++i;
+    }
+    return i - 1;
+}
+}
+
+/** Arithmetic in the Galois field GF(2^n) described by the bit pattern of @p Polynom.
+ *  All field properties and the log/alog tables are compile-time constants, elements are
+ *  stored in the smallest fitting unsigned integer type.
+ */
+template<int Polynom>
+class GaloisField
+{
+public:
+    static constexpr int SymbolSize = GaloisFieldUtil::highestBit(Polynom);
+    static constexpr int Size = 1 << SymbolSize;
+    /** Order of the multiplicative group, the modulus for logarithms. */
+    static constexpr int LogMod = Size - 1;
+    /** Logarithm representing zero, see antiLogTable(). */
+    static constexpr int ZeroLog = 2 * LogMod;
+
+    using Symbol = std::conditional_t<SymbolSize <= 8, quint8, quint16>;
+
+    /** Table of logarithms, the entry for 0 is undefined. */
+    static constexpr const Symbol *logTable()
+    {
+        return s_tables.logTable;
+    }
+    /** Table of powers of the primitive element. The table is repeated, so the sum of two
+     *  logarithms can be looked up without a modulo, and followed by a zero region so that
+     *  ZeroLog plus any logarithm maps to 0.
+     */
+    static constexpr const Symbol *antiLogTable()
+    {
+        return s_tables.antiLogTable;
+    }
+
+    static constexpr int log(Symbol a)
+    {
+        return s_tables.logTable[a];
+    }
+    /** Returns alpha^@p e, for 0 <= @p e < 2 * LogMod. */
+    static constexpr Symbol exp(int e)
+    {
+        return s_tables.antiLogTable[e];
+    }
+    static constexpr Symbol mul(Symbol a, Symbol b)
+    {
+        return a && b ? exp(log(a) + log(b)) : 0;
+    }
+    /** Divides @p a by @p b, @p b must not be 0. */
+    static constexpr Symbol div(Symbol a, Symbol b)
+    {
+        return a ? exp(log(a) + LogMod - log(b)) : 0;
+    }
+    /** Multiplies @p a by alpha^@p e, for 0 <= @p e <= LogMod. */
+    static constexpr Symbol mulExp(Symbol a, int e)
+    {
+        return a ? exp(log(a) + e) : 0;
+    }
+
+private:
+    struct Tables {
+        constexpr Tables()
+        {
+            for (int p = 1, v = 0; v < LogMod; v++) {
+                antiLogTable[v] = Symbol(p);
+                antiLogTable[v + LogMod] = Symbol(p);
+                logTable[p] = Symbol(v);
+                p <<= 1;
+                if (p & Size) {
+                    p ^= Polynom;
+                }
+            }
+        }
+
+        Symbol logTable[Size] = {};
+        Symbol antiLogTable[3 * LogMod] = {};
+    };
+    static constexpr Tables s_tables = {};
+};
+
+}
+
+#endif // PRISON_GALOISFIELD_P_H
@@ -5,6 +5,7 @@
 */
 
 #include "prison.h"
+#include "abstractbarcode_p.h"
 #include "aztecbarcode.h"
 #include "code128barcode.h"
 #include "code39barcode.h"
@@ -14,31 +15,175 @@
 #include "qrcodebarcode.h"
 #include <config-prison.h>
 
-Prison::AbstractBarcode *Prison::createBarcode(BarcodeType type)
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+static Prison::AbstractBarcode *createGenerator(Prison::BarcodeType type)
 {
     switch (type) {
     case Prison::Null:
         return nullptr;
     case Prison::QRCode:
-        return new QRCodeBarcode;
+        return new Prison::QRCodeBarcode;
     case Prison::DataMatrix:
 #if HAVE_DMTX
-        return new DataMatrixBarcode;
+        return new Prison::DataMatrixBarcode;
 #else
         return nullptr;
 #endif
     case Prison::Aztec:
-        return new AztecBarcode;
+        return new Prison::AztecBarcode;
     case Prison::Code39:
-        return new Code39Barcode;
+        return new Prison::Code39Barcode;
     case Prison::Code93:
-        return new Code93Barcode;
+        return new Prison::Code93Barcode;
     case Prison::Code128:
-        return new Code128Barcode;
+        return new Prison::Code128Barcode;
 #if HAVE_ZXING
     case Prison::PDF417:
-        return new Pdf417Barcode;
+        return new Prison::Pdf417Barcode;
 #endif
     }
     return nullptr;
 }
+
+Prison::AbstractBarcode *Prison::createBarcode(BarcodeType type)
+{
+    auto code = createGenerator(type);
+    if (code) {
+        AbstractBarcodePrivate::get(code)->m_type = type;
+    }
+    return code;
+}
+
+// creates a generator for @p type with the given encoding parameters, ready to accept data
+static std::unique_ptr<Prison::AbstractBarcode> createConfiguredBarcode(Prison::BarcodeType type, const Prison::AztecOptions &aztecOptions)
+{
+    std::unique_ptr<Prison::AbstractBarcode> code(Prison::createBarcode(type));
+    if (code) {
+        code->setAztecOptions(aztecOptions);
+    }
+    return code;
+}
+
+template<typename T>
+static Prison::BarcodeMatrix encodeData(Prison::BarcodeType type, const T &data, const Prison::AztecOptions &aztecOptions)
+{
+    // barcode generators don't share any unprotected state between instances,
+    // so a short-lived one per call makes this reentrant
+    const auto code = createConfiguredBarcode(type, aztecOptions);
+    if (!code) {
+        return {};
+    }
+    code->setData(data);
+    return code->matrix();
+}
+
+Prison::BarcodeMatrix Prison::encode(BarcodeType type, const QString &data, const AztecOptions &aztecOptions)
+{
+    return encodeData(type, data, aztecOptions);
+}
+
+Prison::BarcodeMatrix Prison::encode(BarcodeType type, const QByteArray &data, const AztecOptions &aztecOptions)
+{
+    return encodeData(type, data, aztecOptions);
+}
+
+template<typename T>
+static Prison::SymbolInfo symbolInfoData(Prison::BarcodeType type, const T &data, const Prison::AztecOptions &aztecOptions)
+{
+    const auto code = createConfiguredBarcode(type, aztecOptions);
+    if (!code) {
+        return {};
+    }
+    code->setData(data);
+    return Prison::AbstractBarcodePrivate::get(code.get())->symbolInfo();
+}
+
+Prison::SymbolInfo Prison::symbolInfo(BarcodeType type, const QString &data, const AztecOptions &aztecOptions)
+{
+    return symbolInfoData(type, data, aztecOptions);
+}
+
+Prison::SymbolInfo Prison::symbolInfo(BarcodeType type, const QByteArray &data, const AztecOptions &aztecOptions)
+{
+    return symbolInfoData(type, data, aztecOptions);
+}
+
+template<typename T>
+static void encodeBatchData(Prison::BarcodeType type, const T &data, const Prison::BatchCallback &callback, const Prison::AztecOptions &aztecOptions)
+{
+    const int count = int(data.size());
+    const int threadCount = std::max(1, QThread::idealThreadCount());
+    // small enough chunks to keep all threads busy until the end, large enough to not contend on the counter
+    const int chunkSize = std::clamp(count / (threadCount * 8), 1, 64);
+
+    std::atomic<int> next(0);
+    const auto worker = [&]() {
+        // each thread reuses its generator for all payloads it processes. For DataMatrix and PDF417 that
+        // only saves the wrapper object, the libdmtx encoder holds the result of a single encoding and the
+        // ZXing writer is just a set of parameters, so those are still created for every payload.
+        // Batch payloads are typically all different, so this bypasses the symbol cache rather than
+        // contending on its lock and evicting everything else from it.
+        const auto code = createConfiguredBarcode(type, aztecOptions);
+        const auto d = code ? Prison::AbstractBarcodePrivate::get(code.get()) : nullptr;
+        for (int begin = next.fetch_add(chunkSize); begin < count; begin = next.fetch_add(chunkSize)) {
+            const auto end = std::min(begin + chunkSize, count);
+            for (int i = begin; i < end; ++i) {
+                if (!code) {
+                    callback(i, {});
+                    continue;
+                }
+                code->setData(data.at(i));
+                callback(i, d->encode());
+            }
+        }
+    };
+
+    QThreadPool pool;
+    const auto workerCount = std::min(threadCount, (count + chunkSize - 1) / chunkSize);
+    for (int i = 1; i < workerCount; ++i) {
+        pool.start(worker);
+    }
+    worker(); // the calling thread takes part as well
+    pool.waitForDone();
+}
+
+template<typename T>
+static QVector<Prison::BarcodeMatrix> encodeBatchData(Prison::BarcodeType type, const T &data, const Prison::AztecOptions &aztecOptions)
+{
+    QVector<Prison::BarcodeMatrix> results(data.size());
+    auto resultData = results.data();
+    encodeBatchData(
+        type,
+        data,
+        [resultData](int index, const Prison::BarcodeMatrix &matrix) {
+            resultData[index] = matrix;
+        },
+        aztecOptions);
+    return results;
+}
+
+QVector<Prison::BarcodeMatrix> Prison::encodeBatch(BarcodeType type, const QStringList &data, const AztecOptions &aztecOptions)
+{
+    return encodeBatchData(type, data, aztecOptions);
+}
+
+QVector<Prison::BarcodeMatrix> Prison::encodeBatch(BarcodeType type, const QByteArrayList &data, const AztecOptions &aztecOptions)
+{
+    return encodeBatchData(type, data, aztecOptions);
+}
+
+void Prison::encodeBatch(BarcodeType type, const QStringList &data, const BatchCallback &callback, const AztecOptions &aztecOptions)
+{
+    encodeBatchData(type, data, callback, aztecOptions);
+}
+
+void Prison::encodeBatch(BarcodeType type, const QByteArrayList &data, const BatchCallback &callback, const AztecOptions &aztecOptions)
+{
+    encodeBatchData(type, data, callback, aztecOptions);
+}
@@ -9,6 +9,12 @@
 #include "abstractbarcode.h"
 #include "prison_export.h"
 
+#include <QByteArrayList>
+#include <QStringList>
+#include <QVector>
+
+#include <functional>
+
 /**
  * @namespace Prison
  *
@@ -44,6 +50,172 @@ enum BarcodeType {
  * @return a barcode provider, or a null pointer if unsupported. Ownership is passed to the caller.
  */
 PRISON_EXPORT Prison::AbstractBarcode *createBarcode(BarcodeType type);
+
+/**
+ * Encodes textual @p data as a barcode of the given @p type.
+ *
+ * Unlike AbstractBarcode, this does not keep any state between calls and
+ * is safe to call concurrently from multiple threads, for all barcode types.
+ * The resulting matrix is immutable and can be shared between threads freely.
+ *
+ * @param type barcode type. See @ref BarcodeType enum for values
+ * @param data textual barcode content
+ * @param aztecOptions encoding parameters for Aztec codes, ignored for all other types
+ * @return the encoded barcode, or a null matrix if the type is unsupported or
+ * @p data cannot be encoded with it.
+ * @see AbstractBarcode::setData(const QString&), AbstractBarcode::matrix()
+ * @since 5.104
+ */
+PRISON_EXPORT BarcodeMatrix encode(BarcodeType type, const QString &data, const AztecOptions &aztecOptions = {});
+
+/**
+ * Encodes binary @p data as a barcode of the given @p type.
+ *
+ * This is safe to call concurrently from multiple threads.
+ * @see encode(BarcodeType, const QString&, const AztecOptions&)
+ * @since 5.104
+ */
+PRISON_EXPORT BarcodeMatrix encode(BarcodeType type, const QByteArray &data, const AztecOptions &aztecOptions = {});
+
+/**
+ * Geometry of a barcode, as determined by symbolInfo().
+ * @since 5.104
+ */
+struct SymbolInfo {
+    /** @c false if the content cannot be encoded in this barcode type, e.g. because it is too large. */
+    bool fits = false;
+    /** Size of the barcode in modules, including the quiet zone. Same as BarcodeMatrix::size(). */
+    QSize size{0, 0};
+    /** The QR Code version, or the number of data layers of an Aztec code. 0 for all other types. */
+    int version = 0;
+    /** @c true for compact Aztec codes. */
+    bool compact = false;
+};
+
+/**
+ * Determines the geometry of a barcode of the given @p type, without rendering it.
+ *
+ * Where possible this only runs the high-level encoding and evaluates the capacity
+ * of the available symbol sizes, which is considerably cheaper than encode(). That
+ * is currently the case for Aztec, Code 39, Code 93 and Code 128. QR Code, DataMatrix
+ * and PDF417 rely on external encoders without such an API, so this runs the full
+ * encoding for them. The result is only reused by a subsequent encode() if the symbol
+ * cache is enabled. Otherwise, to avoid encoding such content twice, size and render the
+ * same AbstractBarcode instance instead: AbstractBarcode::trueMinimumSize() keeps the
+ * encoded barcode for the following AbstractBarcode::toImage() or AbstractBarcode::matrix().
+ *
+ * Encoding parameters for Aztec codes are passed in @p aztecOptions, the same
+ * way as for encode().
+ *
+ * This function is reentrant and thread-safe.
+ * @since 5.104
+ */
+PRISON_EXPORT SymbolInfo symbolInfo(BarcodeType type, const QString &data, const AztecOptions &aztecOptions = {});
+/**
+ * Determines the geometry of a barcode of the given @p type for binary content.
+ * @see symbolInfo(BarcodeType, const QString&, const AztecOptions&)
+ * @since 5.104
+ */
+PRISON_EXPORT SymbolInfo symbolInfo(BarcodeType type, const QByteArray &data, const AztecOptions &aztecOptions = {});
+
+/**
+ * Encodes a list of textual payloads as barcodes of the given @p type.
+ *
+ * The work is spread over all available CPU cores, with each worker thread
+ * reusing its barcode generator for all payloads it processes. Batch results
+ * are neither looked up in nor added to the symbol cache, so large batches
+ * of one-off payloads don't evict the symbols shared by the rest of the
+ * application. @p aztecOptions is applied to all Aztec payloads, the same way
+ * as for encode().
+ *
+ * @return the encoded barcodes, in the same order as @p data. Entries that
+ * could not be encoded are null matrices.
+ * @see encode(BarcodeType, const QString&, const AztecOptions&)
+ * @since 5.104
+ */
+PRISON_EXPORT QVector<BarcodeMatrix> encodeBatch(BarcodeType type, const QStringList &data, const AztecOptions &aztecOptions = {});
+/**
+ * Encodes a list of binary payloads as barcodes of the given @p type.
+ * @see encodeBatch(BarcodeType, const QStringList&, const AztecOptions&)
+ * @since 5.104
+ */
+PRISON_EXPORT QVector<BarcodeMatrix> encodeBatch(BarcodeType type, const QByteArrayList &data, const AztecOptions &aztecOptions = {});
+
+/**
+ * Callback for streaming batch encoding results.
+ * The first argument is the index of the payload in the input list.
+ * @since 5.104
+ */
+using BatchCallback = std::function<void(int, const BarcodeMatrix &)>;
+
+/**
+ * Encodes a list of textual payloads as barcodes of the given @p type, passing
+ * each result to @p callback as soon as it is available.
+ *
+ * This avoids holding on to all results at the same time for large batches.
+ * @p callback is called exactly once per payload, from the worker threads,
+ * in no particular order and possibly concurrently. This function returns
+ * once all payloads have been processed.
+ *
+ * @since 5.104
+ */
+PRISON_EXPORT void encodeBatch(BarcodeType type, const QStringList &data, const BatchCallback &callback, const AztecOptions &aztecOptions = {});
+/**
+ * Encodes a list of binary payloads as barcodes of the given @p type, passing
+ * each result to @p callback as soon as it is available.
+ * @see encodeBatch(BarcodeType, const QStringList&, const BatchCallback&, const AztecOptions&)
+ * @since 5.104
+ */
+PRISON_EXPORT void encodeBatch(BarcodeType type, const QByteArrayList &data, const BatchCallback &callback, const AztecOptions &aztecOptions = {});
+
+/**
+ * Usage statistics of the symbol cache.
+ * @see symbolCacheStatistics()
+ * @since 5.104
+ */
+struct SymbolCacheStatistics {
+    /** Number of encodings served from the cache. */
+    quint64 hits = 0;
+    /** Number of encodings not found in the cache. */
+    quint64 misses = 0;
+    /** Memory currently used by cached symbols, in bytes. */
+    qint64 cost = 0;
+    /** Number of currently cached symbols. */
+    int count = 0;
+};
+
+/**
+ * Sets the memory budget of the symbol cache, in bytes.
+ *
+ * Once enabled, barcodes produced by createBarcode() or encode() share a process-wide
+ * cache of encoded symbols, keyed by barcode type, content and encoding
+ * options such as AztecOptions. Encoding the same content again, for example
+ * in multiple views or list delegates, then just reuses the already encoded
+ * symbol, and all such barcodes share the same BarcodeMatrix in memory.
+ * The least recently used symbols are evicted once the budget is exceeded.
+ *
+ * The cache is disabled by default, i.e. the default budget is 0. Setting a budget
+ * of 0 disables it again. A budget of 1 MiB holds a couple of hundred typical symbols.
+ * @since 5.104
+ */
+PRISON_EXPORT void setSymbolCacheBudget(qint64 bytes);
+/**
+ * Returns the current memory budget of the symbol cache, in bytes.
+ * @see setSymbolCacheBudget()
+ * @since 5.104
+ */
+PRISON_EXPORT qint64 symbolCacheBudget();
+/**
+ * Returns usage statistics of the symbol cache.
+ * @see setSymbolCacheBudget()
+ * @since 5.104
+ */
+PRISON_EXPORT SymbolCacheStatistics symbolCacheStatistics();
+/**
+ * Removes all entries from the symbol cache and resets its statistics.
+ * @since 5.104
+ */
+PRISON_EXPORT void clearSymbolCache();
 }
 
 #endif // PRISON_PRISON_H
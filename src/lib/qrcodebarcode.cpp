@@ -5,6 +5,8 @@
 */
 
 #include "qrcodebarcode.h"
+#include "barcodematrix_p.h"
+
 #include <qrencode.h>
 
 #include <memory>
@@ -20,6 +22,10 @@ QRCodeBarcode::QRCodeBarcode()
 }
 QRCodeBarcode::~QRCodeBarcode() = default;
 
+enum {
+    QuietZone = 4,
+};
+
 static void qrEncodeString(QRcode_ptr &code, const QByteArray &data)
 {
     // try decreasing ECC levels, in case the higher levels result in overflowing the maximum content size
@@ -59,52 +65,29 @@ QImage QRCodeBarcode::paintImage(const QSizeF &size)
     if (!code) {
         return QImage();
     }
-    const int margin = 4;
-    /*32 bit colors, 8 bit pr byte*/
-    uchar *img = new uchar[4 * sizeof(char *) * (2 * margin + code->width) * (2 * margin * +code->width)];
-    uchar *p = img;
-    QByteArray background;
-    background.resize(4);
-    background[3] = qAlpha(backgroundColor().rgba());
-    background[2] = qRed(backgroundColor().rgba());
-    background[1] = qGreen(backgroundColor().rgba());
-    background[0] = qBlue(backgroundColor().rgba());
-    QByteArray foreground;
-    foreground.resize(4);
-    foreground[3] = qAlpha(foregroundColor().rgba());
-    foreground[2] = qRed(foregroundColor().rgba());
-    foreground[1] = qGreen(foregroundColor().rgba());
-    foreground[0] = qBlue(foregroundColor().rgba());
-    for (int row = 0; row < code->width + 2 * margin; row++) {
-        for (int col = 0; col < code->width + 2 * margin; col++) {
-            if (row < margin || row >= (code->width + margin) || col < margin || col >= (code->width + margin)) {
-                /*4 bytes for color*/
-                for (int i = 0; i < 4; i++) {
-                    *p = background[i];
-                    p++;
-                }
-            } else {
-                int c = (row - margin) * code->width + (col - margin);
-                /*it is bit 1 that is the interesting bit for us from libqrencode*/
-                if (code->data[c] & 1) {
-                    /*4 bytes for color*/
-                    for (int i = 0; i < 4; i++) {
-                        *p = foreground[i];
-                        p++;
-                    }
-                } else {
-                    /*4 bytes for color*/
-                    for (int i = 0; i < 4; i++) {
-                        *p = background[i];
-                        p++;
-                    }
-                }
+    auto img = BarcodeMatrixPrivate::createModuleImage(code->width + 2 * QuietZone, code->width + 2 * QuietZone);
+    for (int row = 0; row < code->width; ++row) {
+        for (int col = 0; col < code->width; ++col) {
+            /*it is bit 1 that is the interesting bit for us from libqrencode*/
+            if (code->data[row * code->width + col] & 1) {
+                BarcodeMatrixPrivate::setModule(&img, col + QuietZone, row + QuietZone);
             }
         }
     }
+    return img;
+}
 
-    const auto result =
-        QImage(img, code->width + 2 * margin, code->width + 2 * margin, QImage::Format_ARGB32).copy(); // deep copy as we are going to delete img
-    delete[] img;
-    return result;
+SymbolInfo QRCodeBarcode::symbolInfo() const
+{
+    // libqrencode selects the version only as part of the full encoding, its capacity tables
+    // and the input splitting that determines the bit stream length aren't public API.
+    // So this encodes, and the matrix stays on this instance for rendering it afterwards.
+    const auto m = matrix();
+    SymbolInfo info;
+    info.fits = !m.isNull();
+    if (info.fits) {
+        info.size = m.size();
+        info.version = (m.width() - 2 * QuietZone - 17) / 4;
+    }
+    return info;
 }
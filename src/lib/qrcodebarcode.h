@@ -8,6 +8,7 @@
 #define PRISON_QRCODEBARCODE_H
 
 #include "abstractbarcode.h"
+#include "prison.h"
 
 namespace Prison
 {
@@ -23,6 +24,12 @@ public:
      */
     QRCodeBarcode();
     ~QRCodeBarcode() override;
+
+    /**
+     * Determines the barcode geometry.
+     * This requires the full encoding, which is kept for rendering later.
+     */
+    SymbolInfo symbolInfo() const;
     /**
      * This is the function doing the actual work in generating the barcode
      * @return QImage containing a QRCode, trying to approximate the requested sizes
@@ -0,0 +1,215 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: MIT
+*/
+
+#include "rasterizer_p.h"
+#include "barcodematrix.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Prison;
+
+static inline bool moduleAt(const uchar *line, int x)
+{
+    return line[x >> 3] & (0x80 >> (x & 7));
+}
+
+static bool isSameRow(const BarcodeMatrix &matrix, int y1, int y2)
+{
+    const auto l1 = matrix.constScanLine(y1);
+    const auto l2 = matrix.constScanLine(y2);
+    const auto fullBytes = matrix.width() / 8;
+    if (std::memcmp(l1, l2, fullBytes) != 0) {
+        return false;
+    }
+    // widths of full bytes have no tail byte, which might be past the end of the last row
+    const uchar tailMask = ~(0xff >> (matrix.width() % 8));
+    return !tailMask || (l1[fullBytes] & tailMask) == (l2[fullBytes] & tailMask);
+}
+
+// one pixel per module: expand eight modules per byte, branch-free so this vectorizes
+template<typename Pixel>
+static void expandModules(const uchar *line, int width, Pixel foreground, Pixel background, Pixel *out)
+{
+    const auto diff = Pixel(foreground ^ background);
+    const auto fullBytes = width / 8;
+    for (int i = 0; i < fullBytes; ++i) {
+        const uint b = line[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            out[bit] = Pixel(background ^ (diff & (0u - ((b >> (7 - bit)) & 1))));
+        }
+        out += 8;
+    }
+    for (int x = fullBytes * 8; x < width; ++x) {
+        *out++ = moduleAt(line, x) ? foreground : background;
+    }
+}
+
+// several pixels per module: fill entire runs of equal modules at once
+template<typename Pixel>
+static void fillRuns(const uchar *line, int width, int scale, Pixel foreground, Pixel background, Pixel *out)
+{
+    for (int x = 0; x < width;) {
+        const auto set = moduleAt(line, x);
+        int end = x + 1;
+        while (end < width && moduleAt(line, end) == set) {
+            ++end;
+        }
+        out = std::fill_n(out, (end - x) * scale, set ? foreground : background);
+        x = end;
+    }
+}
+
+template<typename Pixel>
+static void renderPixels(const BarcodeMatrix &matrix, int scaleX, int scaleY, Pixel foreground, Pixel background, uchar *data, const QSize &size, int bytesPerLine)
+{
+    const auto barcodeWidth = matrix.width() * scaleX;
+    const auto rowBytes = size.width() * sizeof(Pixel);
+    for (int y = 0; y < matrix.height(); ++y) {
+        const auto outY = y * scaleY;
+        auto out = reinterpret_cast<Pixel *>(data + outY * bytesPerLine);
+
+        // identical module rows are common (e.g. PDF417 rows), copy those from the previous output row
+        if (y > 0 && isSameRow(matrix, y - 1, y)) {
+            std::memcpy(out, data + (outY - 1) * bytesPerLine, rowBytes);
+        } else {
+            if (scaleX == 1) {
+                expandModules(matrix.constScanLine(y), matrix.width(), foreground, background, out);
+            } else {
+                fillRuns(matrix.constScanLine(y), matrix.width(), scaleX, foreground, background, out);
+            }
+            std::fill(out + barcodeWidth, out + size.width(), background);
+        }
+
+        for (int i = 1; i < scaleY; ++i) {
+            std::memcpy(data + (outY + i) * bytesPerLine, out, rowBytes);
+        }
+    }
+
+    for (int y = matrix.height() * scaleY; y < size.height(); ++y) {
+        auto out = reinterpret_cast<Pixel *>(data + y * bytesPerLine);
+        std::fill_n(out, size.width(), background);
+    }
+}
+
+// sets bits [begin, end) of a MSB first bit-packed line, whole bytes at once where possible
+static void setBits(uchar *line, int begin, int end)
+{
+    for (; begin < end && (begin & 7); ++begin) {
+        line[begin >> 3] |= 0x80 >> (begin & 7);
+    }
+    const auto fullEnd = end & ~7;
+    if (begin < fullEnd) {
+        std::memset(line + (begin >> 3), 0xff, (fullEnd - begin) >> 3);
+        begin = fullEnd;
+    }
+    for (; begin < end; ++begin) {
+        line[begin >> 3] |= 0x80 >> (begin & 7);
+    }
+}
+
+static void renderMono(const BarcodeMatrix &matrix, int scaleX, int scaleY, uchar *data, const QSize &size, int bytesPerLine)
+{
+    const auto rowBytes = (size.width() + 7) / 8;
+    for (int y = 0; y < matrix.height(); ++y) {
+        const auto outY = y * scaleY;
+        auto out = data + outY * bytesPerLine;
+
+        if (y > 0 && isSameRow(matrix, y - 1, y)) {
+            std::memcpy(out, out - bytesPerLine, rowBytes);
+        } else {
+            std::memset(out, 0, rowBytes);
+            const auto line = matrix.constScanLine(y);
+            if (scaleX == 1) {
+                // same bit layout as the matrix, only the undefined padding bits at the end need to be cleared
+                std::memcpy(out, line, matrix.width() / 8);
+                if (const auto tailBits = matrix.width() % 8) {
+                    out[matrix.width() / 8] = line[matrix.width() / 8] & ~(0xff >> tailBits);
+                }
+            } else {
+                for (int x = 0; x < matrix.width();) {
+                    const auto set = moduleAt(line, x);
+                    int end = x + 1;
+                    while (end < matrix.width() && moduleAt(line, end) == set) {
+                        ++end;
+                    }
+                    if (set) {
+                        setBits(out, x * scaleX, end * scaleX);
+                    }
+                    x = end;
+                }
+            }
+        }
+
+        for (int i = 1; i < scaleY; ++i) {
+            std::memcpy(out + i * bytesPerLine, out, rowBytes);
+        }
+    }
+
+    for (int y = matrix.height() * scaleY; y < size.height(); ++y) {
+        std::memset(data + y * bytesPerLine, 0, rowBytes);
+    }
+}
+
+bool Rasterizer::isSupportedFormat(QImage::Format format)
+{
+    switch (format) {
+    case QImage::Format_Mono:
+    case QImage::Format_Grayscale8:
+    case QImage::Format_Indexed8:
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void Rasterizer::render(const BarcodeMatrix &matrix,
+                        int scaleX,
+                        int scaleY,
+                        QRgb foreground,
+                        QRgb background,
+                        uchar *data,
+                        const QSize &size,
+                        int bytesPerLine,
+                        QImage::Format format)
+{
+    switch (format) {
+    case QImage::Format_Mono:
+        renderMono(matrix, scaleX, scaleY, data, size, bytesPerLine);
+        break;
+    case QImage::Format_Grayscale8:
+        renderPixels<uchar>(matrix, scaleX, scaleY, qGray(foreground), qGray(background), data, size, bytesPerLine);
+        break;
+    case QImage::Format_Indexed8:
+        renderPixels<uchar>(matrix, scaleX, scaleY, 1, 0, data, size, bytesPerLine);
+        break;
+    case QImage::Format_RGB32:
+        renderPixels<QRgb>(matrix, scaleX, scaleY, foreground | 0xff000000, background | 0xff000000, data, size, bytesPerLine);
+        break;
+    case QImage::Format_ARGB32:
+        renderPixels<QRgb>(matrix, scaleX, scaleY, foreground, background, data, size, bytesPerLine);
+        break;
+    case QImage::Format_ARGB32_Premultiplied:
+        renderPixels<QRgb>(matrix, scaleX, scaleY, qPremultiply(foreground), qPremultiply(background), data, size, bytesPerLine);
+        break;
+    default:
+        Q_UNREACHABLE();
+    }
+}
+
+QImage Rasterizer::render(const BarcodeMatrix &matrix, int scaleX, int scaleY, QRgb foreground, QRgb background)
+{
+    if (matrix.isNull() || scaleX < 1 || scaleY < 1) {
+        return {};
+    }
+
+    QImage img(matrix.width() * scaleX, matrix.height() * scaleY, QImage::Format_ARGB32);
+    render(matrix, scaleX, scaleY, foreground, background, img.bits(), img.size(), img.bytesPerLine(), img.format());
+    return img;
+}
@@ -0,0 +1,45 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: MIT
+*/
+
+#ifndef PRISON_RASTERIZER_P_H
+#define PRISON_RASTERIZER_P_H
+
+#include <QImage>
+
+namespace Prison
+{
+class BarcodeMatrix;
+
+/** Renders module matrices into images, scaled by integer factors. */
+namespace Rasterizer
+{
+/** Renders @p matrix into a newly allocated QImage::Format_ARGB32 image,
+ *  with each module being @p scaleX x @p scaleY pixels in size.
+ */
+QImage render(const BarcodeMatrix &matrix, int scaleX, int scaleY, QRgb foreground, QRgb background);
+
+/** Returns @c true if render() can write pixels of the given @p format. */
+bool isSupportedFormat(QImage::Format format);
+
+/** Renders @p matrix into an existing buffer of @p size pixels in the given @p format.
+ *  The barcode is placed in the top left corner, the remaining area is filled with @p background.
+ *  For QImage::Format_Mono and QImage::Format_Indexed8 set modules are written as color index 1,
+ *  and the background as color index 0, the colors are ignored in that case.
+ *  The caller has to ensure the matrix fits into @p size when scaled.
+ */
+void render(const BarcodeMatrix &matrix,
+            int scaleX,
+            int scaleY,
+            QRgb foreground,
+            QRgb background,
+            uchar *data,
+            const QSize &size,
+            int bytesPerLine,
+            QImage::Format format);
+}
+}
+
+#endif // PRISON_RASTERIZER_P_H
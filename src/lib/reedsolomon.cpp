@@ -5,87 +5,343 @@
 */
 
 #include "bitvector_p.h"
+#include "galoisfield_p.h"
 #include "reedsolomon_p.h"
 
+#include <QHash>
+#include <QMutex>
+#include <QVarLengthArray>
+#include <QVector>
 
-#include <memory>
+#include <algorithm>
 
 using namespace Prison;
 
 // See https://en.wikiversity.org/wiki/Reed%E2%80%93Solomon_codes_for_coders
 
-static int highestBit(int n)
+namespace Prison
 {
-    int i = 0;
-    while (n >= (1 << i)) {
-        ++i;
-    }
-    return i - 1;
+// Encoder/decoder for a specific field and symbol count, shared between all
+// ReedSolomon instances with the same parameters.
+class ReedSolomonGenerator
+{
+public:
+    virtual ~ReedSolomonGenerator() = default;
+    virtual void encode(const quint16 *data, int dataCount, int blockCount, quint16 *ecc) const = 0;
+    virtual int decode(quint16 *codewords, int count) const = 0;
+};
 }
 
-ReedSolomon::ReedSolomon(int polynom, int symbolCount)
-    : m_symCount(symbolCount)
+namespace
+{
+template<typename Field>
+class ReedSolomonCodec : public ReedSolomonGenerator
 {
-    m_symSize = highestBit(polynom);
+public:
+    using Symbol = typename Field::Symbol;
 
-    // calculate the log/alog tables
-    const auto logmod = (1 << m_symSize) - 1;
-    m_logTable.reset(new int[logmod + 1]);
-    m_antiLogTable.reset(new int[logmod]);
+    explicit ReedSolomonCodec(int symCount);
+    void encode(const quint16 *data, int dataCount, int blockCount, quint16 *ecc) const override;
+    int decode(quint16 *codewords, int count) const override;
 
-    for (int p = 1, v = 0; v < logmod; v++) {
-        m_antiLogTable[v] = p;
-        m_logTable[p] = v;
-        p <<= 1;
-        if (p & (1 << m_symSize)) {
-            p ^= polynom;
-        }
-    }
+private:
+    inline void lfsrStep(Symbol *window, int input) const;
+    // evaluates the polynom with coefficients @p poly, lowest degree first, at alpha^exponent
+    static inline int evaluate(const int *poly, int size, int exponent);
+
+    int m_symCount;
+    // fields of up to 8 bits: products of the reversed generator polynom coefficients with all
+    // values of the low nibble (16 rows), followed by those for all values of the high nibble
+    QVector<quint8> m_nibbleProducts;
+    // larger fields: logarithms of the reversed generator polynom coefficients, ZeroLog for zero coefficients
+    QVector<quint16> m_logPolynom;
+};
 
+template<typename Field>
+ReedSolomonCodec<Field>::ReedSolomonCodec(int symCount)
+    : m_symCount(symCount)
+{
     // compute the encoding polynom
-    m_polynom.reset(new int[m_symCount + 1]);
-    m_polynom[0] = 1;
+    QVarLengthArray<Symbol, 256> p(m_symCount + 1);
+    p[0] = 1;
     for (int i = 1; i <= m_symCount; ++i) {
-        m_polynom[i] = 1;
+        p[i] = 1;
         for (int k = i - 1; k > 0; --k) {
-            if (m_polynom[k]) {
-                m_polynom[k] = m_antiLogTable[(m_logTable[m_polynom[k]] + i) % logmod];
+            p[k] = Field::mulExp(p[k], i) ^ p[k - 1];
+        }
+        p[0] = Field::mulExp(p[0], i);
+    }
+
+    // The LFSR update of the encoder needs the product of the feedback symbol with all
+    // coefficients, highest degree first.
+    if constexpr (Field::SymbolSize <= 8) {
+        constexpr auto rowCount = 16 + (1 << std::max(0, Field::SymbolSize - 4));
+        m_nibbleProducts.resize(rowCount * m_symCount);
+        auto products = m_nibbleProducts.data();
+        for (int row = 0; row < rowCount; ++row) {
+            const auto m = Symbol(row < 16 ? row : (row - 16) << 4);
+            for (int j = 0; j < m_symCount; ++j) {
+                *products++ = Field::mul(m, p[m_symCount - 1 - j]);
             }
-            m_polynom[k] ^= m_polynom[k - 1];
         }
-        m_polynom[0] = m_antiLogTable[(m_logTable[m_polynom[0]] + i) % logmod];
+    } else {
+        m_logPolynom.resize(m_symCount);
+        for (int j = 0; j < m_symCount; ++j) {
+            const auto coeff = p[m_symCount - 1 - j];
+            m_logPolynom[j] = coeff ? Field::log(coeff) : Field::ZeroLog;
+        }
     }
 }
 
-ReedSolomon::~ReedSolomon() = default;
+// The LFSR state of each block is kept as a window of symCount symbols sliding over a
+// buffer that has room for all input symbols, highest degree first. Advancing by one input
+// symbol then is a single XOR of one contiguous product row into the window, which
+// the compiler can vectorize.
+template<typename Field>
+void ReedSolomonCodec<Field>::lfsrStep(Symbol *window, int input) const
+{
+    const auto m = window[0] ^ input;
+    if (!m) {
+        return;
+    }
+    ++window;
+    if constexpr (Field::SymbolSize <= 8) {
+        const auto low = m_nibbleProducts.constData() + (m & 0xf) * m_symCount;
+        const auto high = m_nibbleProducts.constData() + (16 + (m >> 4)) * m_symCount;
+        for (int j = 0; j < m_symCount; ++j) {
+            window[j] ^= low[j] ^ high[j];
+        }
+    } else {
+        const auto antiLog = Field::antiLogTable() + Field::log(m);
+        const auto logPolynom = m_logPolynom.constData();
+        for (int j = 0; j < m_symCount; ++j) {
+            window[j] ^= antiLog[logPolynom[j]];
+        }
+    }
+}
+
+template<typename Field>
+void ReedSolomonCodec<Field>::encode(const quint16 *data, int dataCount, int blockCount, quint16 *ecc) const
+{
+    // small enough to not need a heap allocation for mode messages and small symbols
+    const auto stride = dataCount + m_symCount;
+    QVarLengthArray<Symbol, 256> buffer(stride * blockCount);
+    std::fill(buffer.begin(), buffer.end(), 0);
+    for (int i = 0; i < dataCount; ++i) {
+        for (int b = 0; b < blockCount; ++b) {
+            lfsrStep(buffer.data() + b * stride + i, *data++ & Field::LogMod);
+        }
+    }
+    for (int k = 0; k < m_symCount; ++k) {
+        for (int b = 0; b < blockCount; ++b) {
+            *ecc++ = buffer[b * stride + dataCount + k];
+        }
+    }
+}
 
-BitVector ReedSolomon::encode(const BitVector &input) const
+template<typename Field>
+int ReedSolomonCodec<Field>::evaluate(const int *poly, int size, int exponent)
 {
-    std::unique_ptr<int[]> result(new int[m_symCount]);
-    for (int i = 0; i < m_symCount; ++i) {
-        result[i] = 0;
+    int res = 0;
+    for (int i = size - 1; i >= 0; --i) {
+        res = Field::mulExp(res, exponent) ^ poly[i];
     }
+    return res;
+}
 
-    const auto logmod = (1 << m_symSize) - 1;
-    for (int i = 0; i < input.size() / m_symSize; i++) {
-        auto m = result[m_symCount - 1] ^ input.valueAtMSB(i * m_symSize, m_symSize);
-        for (int k = m_symCount - 1; k > 0; --k) {
-            if (m && m_polynom[k]) {
-                result[k] = result[k - 1] ^ m_antiLogTable[(m_logTable[m] + m_logTable[m_polynom[k]]) % logmod];
-            } else {
-                result[k] = result[k - 1];
-            }
+// See https://en.wikiversity.org/wiki/Reed%E2%80%93Solomon_codes_for_coders#Error_correction
+template<typename Field>
+int ReedSolomonCodec<Field>::decode(quint16 *codewords, int count) const
+{
+    if (count > Field::LogMod || count < m_symCount) {
+        return -1;
+    }
+
+    // syndromes, the code word polynom evaluated at the roots of the generator polynom alpha^1...alpha^symCount
+    QVarLengthArray<int, 64> syndromes(m_symCount);
+    bool hasErrors = false;
+    for (int j = 0; j < m_symCount; ++j) {
+        Symbol s = 0;
+        for (int i = 0; i < count; ++i) {
+            s = Field::mulExp(s, j + 1) ^ (codewords[i] & Field::LogMod);
+        }
+        syndromes[j] = s;
+        hasErrors |= s != 0;
+    }
+    if (!hasErrors) {
+        return 0;
+    }
+
+    // Berlekamp-Massey, computing the error locator polynom, lowest degree first
+    QVarLengthArray<int, 64> locator(m_symCount + 1);
+    QVarLengthArray<int, 64> prevLocator(m_symCount + 1);
+    std::fill(locator.begin(), locator.end(), 0);
+    std::fill(prevLocator.begin(), prevLocator.end(), 0);
+    locator[0] = prevLocator[0] = 1;
+    int errorCount = 0;
+    int shift = 1;
+    int prevDiscrepancy = 1;
+    for (int n = 0; n < m_symCount; ++n) {
+        int discrepancy = syndromes[n];
+        for (int i = 1; i <= errorCount; ++i) {
+            discrepancy ^= Field::mul(locator[i], syndromes[n - i]);
         }
-        if (m && m_polynom[0]) {
-            result[0] = m_antiLogTable[(m_logTable[m] + m_logTable[m_polynom[0]]) % logmod];
+        if (discrepancy == 0) {
+            ++shift;
+            continue;
+        }
+        const auto factor = Field::div(discrepancy, prevDiscrepancy);
+        if (2 * errorCount <= n) {
+            const auto tmp = locator;
+            for (int i = 0; i + shift <= m_symCount; ++i) {
+                locator[i + shift] ^= Field::mul(factor, prevLocator[i]);
+            }
+            errorCount = n + 1 - errorCount;
+            prevLocator = tmp;
+            prevDiscrepancy = discrepancy;
+            shift = 1;
         } else {
-            result[0] = 0;
+            for (int i = 0; i + shift <= m_symCount; ++i) {
+                locator[i + shift] ^= Field::mul(factor, prevLocator[i]);
+            }
+            ++shift;
+        }
+    }
+    if (2 * errorCount > m_symCount) {
+        return -1;
+    }
+
+    // error evaluator polynom, (syndromes * locator) mod x^symCount, of which only
+    // the terms below errorCount can be non-zero
+    QVarLengthArray<int, 64> evaluator(errorCount);
+    for (int k = 0; k < errorCount; ++k) {
+        evaluator[k] = 0;
+        for (int i = 0; i <= k; ++i) {
+            evaluator[k] ^= Field::mul(syndromes[k - i], locator[i]);
+        }
+    }
+    // formal derivative of the error locator, in characteristic 2 only the odd terms remain
+    QVarLengthArray<int, 64> derivative(errorCount);
+    for (int i = 0; i < errorCount; ++i) {
+        derivative[i] = (i % 2 == 0) ? locator[i + 1] : 0;
+    }
+
+    // Chien search for the roots of the error locator, and Forney for the error values
+    int corrected = 0;
+    for (int i = 0; i < count; ++i) {
+        const auto degree = count - 1 - i;
+        const auto inverseExponent = (Field::LogMod - degree) % Field::LogMod; // X^-1 for X = alpha^degree
+        if (evaluate(locator.constData(), errorCount + 1, inverseExponent) != 0) {
+            continue;
         }
+        const auto denominator = evaluate(derivative.constData(), errorCount, inverseExponent);
+        if (denominator == 0) {
+            return -1;
+        }
+        codewords[i] ^= Field::div(evaluate(evaluator.constData(), errorCount, inverseExponent), denominator);
+        ++corrected;
+    }
+    if (corrected != errorCount) {
+        return -1;
+    }
+    return corrected;
+}
+
+template<int Polynom>
+std::shared_ptr<const ReedSolomonGenerator> makeCodec(int symCount)
+{
+    return std::make_shared<ReedSolomonCodec<GaloisField<Polynom>>>(symCount);
+}
+
+std::shared_ptr<const ReedSolomonGenerator> makeCodec(int polynom, int symCount)
+{
+    switch (polynom) {
+    case ReedSolomon::GF16:
+        return makeCodec<ReedSolomon::GF16>(symCount);
+    case ReedSolomon::GF64:
+        return makeCodec<ReedSolomon::GF64>(symCount);
+    case ReedSolomon::GF256:
+        return makeCodec<ReedSolomon::GF256>(symCount);
+    case ReedSolomon::GF1024:
+        return makeCodec<ReedSolomon::GF1024>(symCount);
+    case ReedSolomon::GF4096:
+        return makeCodec<ReedSolomon::GF4096>(symCount);
+    }
+    Q_UNREACHABLE();
+    return {};
+}
+
+// generator polynoms, per field and symbol count
+struct GeneratorCache {
+    QMutex mutex;
+    QHash<quint32, std::shared_ptr<const ReedSolomonGenerator>> generators;
+};
+}
+
+Q_GLOBAL_STATIC(GeneratorCache, s_generatorCache)
+
+ReedSolomon::ReedSolomon(int polynom, int symbolCount)
+    : m_symCount(symbolCount)
+    , m_symSize(GaloisFieldUtil::highestBit(polynom))
+{
+    Q_ASSERT(symbolCount >= 0 && symbolCount < (1 << m_symSize));
+    const quint32 key = (quint32(polynom) << 16) | quint32(symbolCount);
+    auto cache = s_generatorCache();
+    QMutexLocker locker(&cache->mutex);
+    const auto it = cache->generators.constFind(key);
+    if (it != cache->generators.constEnd()) {
+        m_generator = it.value();
+        return;
+    }
+    locker.unlock();
+
+    m_generator = makeCodec(polynom, symbolCount);
+
+    locker.relock();
+    cache->generators.insert(key, m_generator);
+}
+
+ReedSolomon::~ReedSolomon() = default;
+
+BitVector ReedSolomon::encode(BitVectorView input) const
+{
+    QVarLengthArray<quint16, 256> data(input.size() / m_symSize);
+    auto reader = input.reader();
+    for (auto &sym : data) {
+        sym = quint16(reader.read(m_symSize));
     }
+    QVarLengthArray<quint16, 64> ecc(m_symCount);
+    m_generator->encode(data.constData(), data.size(), 1, ecc.data());
 
     BitVector v;
-    for (int i = m_symCount - 1; i >= 0; --i) {
-        v.appendMSB(result[i], m_symSize);
+    v.reserve(m_symCount * m_symSize);
+    for (const auto sym : ecc) {
+        v.appendMSB(sym, m_symSize);
     }
     return v;
 }
+
+void ReedSolomon::encode(const quint16 *data, int dataCount, quint16 *ecc) const
+{
+    m_generator->encode(data, dataCount, 1, ecc);
+}
+
+void ReedSolomon::encodeInterleaved(const quint16 *data, int dataCount, int blockCount, quint16 *ecc) const
+{
+    m_generator->encode(data, dataCount, blockCount, ecc);
+}
+
+int ReedSolomon::decode(quint16 *codewords, int count) const
+{
+    return m_generator->decode(codewords, count);
+}
+
+int ReedSolomon::symbolCount() const
+{
+    return m_symCount;
+}
+
+int ReedSolomon::symbolSize() const
+{
+    return m_symSize;
+}
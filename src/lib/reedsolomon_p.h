@@ -7,11 +7,15 @@
 #ifndef PRISON_REEDSOLOMON_P_H
 #define PRISON_REEDSOLOMON_P_H
 
+#include <QtGlobal>
+
 #include <memory>
 
 namespace Prison
 {
 class BitVector;
+class BitVectorView;
+class ReedSolomonGenerator;
 
 /** Reed Solomon checksum generator. */
 class ReedSolomon
@@ -28,6 +32,8 @@ public:
     /** Initialize a Reed Solomon encoder with the Galois Field
      *  described by the bit pattern of @p polynom, for generating
      *  @p symbolCount error correction symbols.
+     *  @p polynom has to be one of the fields in GF. Field tables and
+     *  generator polynoms are shared between all instances, making this cheap.
      */
     explicit ReedSolomon(int polynom, int symbolCount);
     ReedSolomon(const ReedSolomon &) = delete;
@@ -36,12 +42,39 @@ public:
     /** Encode the content of @p input and return the resulting
      *  code words.
      */
-    BitVector encode(const BitVector &input) const;
+    BitVector encode(BitVectorView input) const;
+
+    /** Encode the @p dataCount code words in @p data, and write the resulting
+     *  symbolCount() error correction code words to @p ecc.
+     *  Code words are stored one per element, only the lowest symbolSize() bits are used.
+     */
+    void encode(const quint16 *data, int dataCount, quint16 *ecc) const;
+
+    /** Encode @p blockCount blocks of @p dataCount code words each in one go.
+     *  @p data contains the blocks interleaved code word by code word, that is
+     *  code word @c i of block @c b is at <tt>data[i * blockCount + b]</tt>, and
+     *  the error correction code words are written to @p ecc interleaved the same way,
+     *  <tt>symbolCount() * blockCount</tt> in total.
+     *  Symbologies with blocks of different lengths encode each group of equally
+     *  sized blocks separately.
+     */
+    void encodeInterleaved(const quint16 *data, int dataCount, int blockCount, quint16 *ecc) const;
+
+    /** Correct errors in the @p count code words in @p codewords in place.
+     *  @p codewords contains the data code words followed by the symbolCount()
+     *  error correction code words, as produced by encode(). Up to symbolCount() / 2
+     *  erroneous code words can be corrected.
+     *  @returns the number of corrected code words, or -1 if the errors could not be corrected.
+     */
+    int decode(quint16 *codewords, int count) const;
+
+    /** Amount of error correction code words generated. */
+    int symbolCount() const;
+    /** Size of a code word in bits. */
+    int symbolSize() const;
 
 private:
-    std::unique_ptr<int[]> m_logTable;
-    std::unique_ptr<int[]> m_antiLogTable;
-    std::unique_ptr<int[]> m_polynom;
+    std::shared_ptr<const ReedSolomonGenerator> m_generator;
     int m_symCount = 0;
     int m_symSize = 0;
 };
@@ -0,0 +1,112 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: MIT
+*/
+
+#include "symbolcache_p.h"
+
+#include <QCache>
+#include <QMutex>
+#include <QVariant>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+using namespace Prison;
+
+namespace
+{
+// the cache is opt-in, until an application sets a budget encoding doesn't touch the mutex
+struct SymbolCacheData {
+    QMutex mutex;
+    QCache<QByteArray, BarcodeMatrix> cache{0};
+    quint64 hits = 0;
+    quint64 misses = 0;
+    std::atomic<bool> enabled{false};
+};
+}
+
+Q_GLOBAL_STATIC(SymbolCacheData, s_cache)
+
+bool SymbolCache::isEnabled()
+{
+    return s_cache->enabled.load(std::memory_order_relaxed);
+}
+
+QByteArray SymbolCache::key(BarcodeType type, const QVariant &data, const QByteArray &parameters)
+{
+    // textual and binary content of the same bytes must not collide, as generators can encode them differently,
+    // and neither must the same content encoded with different parameters
+    QByteArray key;
+    const auto appendHeader = [&](int payloadSize, char contentType) {
+        key.reserve(3 + parameters.size() + payloadSize);
+        key.append(char(type));
+        key.append(char(parameters.size()));
+        key.append(parameters);
+        key.append(contentType);
+    };
+    if (data.type() == QVariant::String) {
+        const auto s = data.toString();
+        appendHeader(s.size() * int(sizeof(QChar)), 's');
+        key.append(reinterpret_cast<const char *>(s.constData()), s.size() * int(sizeof(QChar)));
+    } else {
+        const auto b = data.toByteArray();
+        appendHeader(b.size(), 'b');
+        key.append(b);
+    }
+    return key;
+}
+
+BarcodeMatrix SymbolCache::find(const QByteArray &key)
+{
+    QMutexLocker locker(&s_cache->mutex);
+    if (const auto matrix = s_cache->cache.object(key)) {
+        ++s_cache->hits;
+        return *matrix;
+    }
+    ++s_cache->misses;
+    return {};
+}
+
+void SymbolCache::insert(const QByteArray &key, const BarcodeMatrix &matrix)
+{
+    const auto cost = key.size() + matrix.bytesPerLine() * matrix.height();
+    QMutexLocker locker(&s_cache->mutex);
+    // entries exceeding the budget are rejected and deleted by QCache
+    s_cache->cache.insert(key, new BarcodeMatrix(matrix), cost);
+}
+
+void Prison::setSymbolCacheBudget(qint64 bytes)
+{
+    const auto budget = std::clamp<qint64>(bytes, 0, std::numeric_limits<int>::max());
+    QMutexLocker locker(&s_cache->mutex);
+    s_cache->cache.setMaxCost(int(budget));
+    s_cache->enabled = budget > 0;
+}
+
+qint64 Prison::symbolCacheBudget()
+{
+    QMutexLocker locker(&s_cache->mutex);
+    return s_cache->cache.maxCost();
+}
+
+Prison::SymbolCacheStatistics Prison::symbolCacheStatistics()
+{
+    QMutexLocker locker(&s_cache->mutex);
+    SymbolCacheStatistics stats;
+    stats.hits = s_cache->hits;
+    stats.misses = s_cache->misses;
+    stats.cost = s_cache->cache.totalCost();
+    stats.count = int(s_cache->cache.count());
+    return stats;
+}
+
+void Prison::clearSymbolCache()
+{
+    QMutexLocker locker(&s_cache->mutex);
+    s_cache->cache.clear();
+    s_cache->hits = 0;
+    s_cache->misses = 0;
+}
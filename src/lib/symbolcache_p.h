@@ -0,0 +1,40 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: MIT
+*/
+
+#ifndef PRISON_SYMBOLCACHE_P_H
+#define PRISON_SYMBOLCACHE_P_H
+
+#include "barcodematrix.h"
+#include "prison.h"
+
+class QByteArray;
+class QVariant;
+
+namespace Prison
+{
+
+/** Process-wide LRU cache of encoded barcodes, shared by all built-in generators.
+ *  All functions are thread-safe.
+ */
+namespace SymbolCache
+{
+/** Returns @c false if the cache has been disabled by setting its budget to 0. */
+bool isEnabled();
+
+/** Content-addressed lookup key for encoding @p data as barcode @p type,
+ *  with generator specific encoding @p parameters.
+ */
+QByteArray key(BarcodeType type, const QVariant &data, const QByteArray &parameters = {});
+
+/** Returns the cached matrix for @p key, or a null matrix on a cache miss. */
+BarcodeMatrix find(const QByteArray &key);
+/** Adds @p matrix to the cache, evicting the least recently used entries if necessary. */
+void insert(const QByteArray &key, const BarcodeMatrix &matrix);
+}
+
+}
+
+#endif // PRISON_SYMBOLCACHE_P_H
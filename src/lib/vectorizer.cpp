@@ -0,0 +1,218 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: MIT
+*/
+
+#include "vectorizer_p.h"
+#include "barcodematrix.h"
+
+#include <QByteArray>
+#include <QColor>
+#include <QIODevice>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <vector>
+
+using namespace Prison;
+
+static inline bool moduleAt(const uchar *line, int x)
+{
+    return line[x >> 3] & (0x80 >> (x & 7));
+}
+
+QVector<QRect> Vectorizer::rectangles(const BarcodeMatrix &matrix)
+{
+    QVector<QRect> result;
+    std::vector<QRect> open; // rectangles extending to the previous row, ordered by x
+    std::vector<QRect> next;
+    for (int y = 0; y < matrix.height(); ++y) {
+        const auto line = matrix.constScanLine(y);
+        auto it = open.begin();
+        for (int x = 0; x < matrix.width();) {
+            // skip entire unset bytes
+            if ((x & 7) == 0 && line[x >> 3] == 0) {
+                x += 8;
+                continue;
+            }
+            if (!moduleAt(line, x)) {
+                ++x;
+                continue;
+            }
+            int end = x + 1;
+            while (end < matrix.width() && moduleAt(line, end)) {
+                ++end;
+            }
+
+            // rectangles not continued in this row are complete
+            for (; it != open.end() && it->left() < x; ++it) {
+                result.push_back(*it);
+            }
+            if (it != open.end() && it->left() == x && it->right() == end - 1) {
+                next.push_back(QRect(it->topLeft(), QSize(it->width(), it->height() + 1)));
+                ++it;
+            } else {
+                next.push_back(QRect(x, y, end - x, 1));
+            }
+            x = end;
+        }
+        std::copy(it, open.end(), std::back_inserter(result));
+        std::swap(open, next);
+        next.clear();
+    }
+    std::copy(open.begin(), open.end(), std::back_inserter(result));
+    return result;
+}
+
+// shortest representation without exponent notation, as not all consumers support that
+static QByteArray number(qreal value)
+{
+    auto s = QByteArray::number(value, 'f', 4);
+    if (s.contains('.')) {
+        while (s.endsWith('0')) {
+            s.chop(1);
+        }
+        if (s.endsWith('.')) {
+            s.chop(1);
+        }
+    }
+    return s;
+}
+
+static QByteArray rgbComponents(QRgb color)
+{
+    return number(qRed(color) / 255.0) + ' ' + number(qGreen(color) / 255.0) + ' ' + number(qBlue(color) / 255.0);
+}
+
+static QByteArray svgFill(QRgb color)
+{
+    QByteArray s = "fill=\"" + QColor(color).name().toLatin1() + '"';
+    if (qAlpha(color) != 255) {
+        s += " fill-opacity=\"" + number(qAlpha(color) / 255.0) + '"';
+    }
+    return s;
+}
+
+// write in chunks of about this size, to not hit the device for every rectangle
+static constexpr int ChunkSize = 16384;
+
+static bool flush(QIODevice *device, QByteArray &buffer, int threshold = 0)
+{
+    if (buffer.size() < threshold) {
+        return true;
+    }
+    const auto ok = device->write(buffer) == buffer.size();
+    buffer.clear();
+    return ok;
+}
+
+static bool writeSvg(QIODevice *device, const BarcodeMatrix &matrix, const QSizeF &size, QRgb foreground, QRgb background)
+{
+    const auto w = QByteArray::number(matrix.width());
+    const auto h = QByteArray::number(matrix.height());
+
+    // everything is in module coordinates, the viewBox takes care of the scaling
+    QByteArray buffer;
+    buffer.reserve(ChunkSize + 64);
+    buffer += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+              "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" width=\""
+        + number(size.width()) + "\" height=\"" + number(size.height()) + "\" viewBox=\"0 0 " + w + ' ' + h
+        + "\" preserveAspectRatio=\"none\" shape-rendering=\"crispEdges\">\n";
+    if (qAlpha(background)) {
+        buffer += "<rect width=\"" + w + "\" height=\"" + h + "\" " + svgFill(background) + "/>\n";
+    }
+    buffer += "<path " + svgFill(foreground) + " d=\"";
+    for (const auto &r : Vectorizer::rectangles(matrix)) {
+        buffer += 'M' + QByteArray::number(r.x()) + ' ' + QByteArray::number(r.y()) + 'h' + QByteArray::number(r.width()) + 'v'
+            + QByteArray::number(r.height()) + 'h' + QByteArray::number(-r.width()) + 'z';
+        if (!flush(device, buffer, ChunkSize)) {
+            return false;
+        }
+    }
+    buffer += "\"/>\n</svg>\n";
+    return flush(device, buffer);
+}
+
+static bool writeEps(QIODevice *device, const BarcodeMatrix &matrix, const QSizeF &size, QRgb foreground, QRgb background)
+{
+    QByteArray buffer;
+    buffer.reserve(ChunkSize + 64);
+    buffer += "%!PS-Adobe-3.0 EPSF-3.0\n"
+              "%%BoundingBox: 0 0 "
+        + QByteArray::number(int(std::ceil(size.width()))) + ' ' + QByteArray::number(int(std::ceil(size.height())))
+        + "\n"
+          "%%HiResBoundingBox: 0 0 "
+        + number(size.width()) + ' ' + number(size.height())
+        + "\n"
+          "%%Creator: KDE Prison\n"
+          "%%EndComments\n"
+          "gsave\n"
+          "/R { rectfill } bind def\n"
+          // PostScript has the origin at the bottom left, flip to module coordinates
+          "0 "
+        + number(size.height()) + " translate " + number(size.width() / matrix.width()) + ' ' + number(-size.height() / matrix.height()) + " scale\n";
+    if (qAlpha(background)) {
+        buffer += rgbComponents(background) + " setrgbcolor 0 0 " + QByteArray::number(matrix.width()) + ' ' + QByteArray::number(matrix.height()) + " R\n";
+    }
+    buffer += rgbComponents(foreground) + " setrgbcolor\n";
+    for (const auto &r : Vectorizer::rectangles(matrix)) {
+        buffer += QByteArray::number(r.x()) + ' ' + QByteArray::number(r.y()) + ' ' + QByteArray::number(r.width()) + ' ' + QByteArray::number(r.height())
+            + " R\n";
+        if (!flush(device, buffer, ChunkSize)) {
+            return false;
+        }
+    }
+    buffer += "grestore\n%%EOF\n";
+    return flush(device, buffer);
+}
+
+static bool writePdf(QIODevice *device, const BarcodeMatrix &matrix, const QSizeF &size, QRgb foreground, QRgb background)
+{
+    // the content stream length has to be known upfront, so that one is assembled in memory
+    QByteArray content = "q\n" + number(size.width() / matrix.width()) + " 0 0 " + number(-size.height() / matrix.height()) + " 0 " + number(size.height())
+        + " cm\n";
+    if (qAlpha(background)) {
+        content += rgbComponents(background) + " rg\n0 0 " + QByteArray::number(matrix.width()) + ' ' + QByteArray::number(matrix.height()) + " re f\n";
+    }
+    content += rgbComponents(foreground) + " rg\n";
+    for (const auto &r : Vectorizer::rectangles(matrix)) {
+        content += QByteArray::number(r.x()) + ' ' + QByteArray::number(r.y()) + ' ' + QByteArray::number(r.width()) + ' ' + QByteArray::number(r.height())
+            + " re\n";
+    }
+    content += "f\nQ\n";
+
+    QByteArray pdf = "%PDF-1.4\n";
+    std::vector<int> offsets;
+    const auto addObject = [&pdf, &offsets](const QByteArray &obj) {
+        offsets.push_back(pdf.size());
+        pdf += QByteArray::number(int(offsets.size())) + " 0 obj\n" + obj + "\nendobj\n";
+    };
+    addObject("<< /Type /Catalog /Pages 2 0 R >>");
+    addObject("<< /Type /Pages /Kids [3 0 R] /Count 1 >>");
+    addObject("<< /Type /Page /Parent 2 0 R /MediaBox [0 0 " + number(size.width()) + ' ' + number(size.height())
+              + "] /Resources << >> /Contents 4 0 R >>");
+    addObject("<< /Length " + QByteArray::number(content.size()) + " >>\nstream\n" + content + "endstream");
+
+    const auto xrefOffset = pdf.size();
+    pdf += "xref\n0 " + QByteArray::number(int(offsets.size()) + 1) + "\n0000000000 65535 f \n";
+    for (const auto offset : offsets) {
+        pdf += QByteArray::number(offset).rightJustified(10, '0') + " 00000 n \n";
+    }
+    pdf += "trailer\n<< /Size " + QByteArray::number(int(offsets.size()) + 1) + " /Root 1 0 R >>\nstartxref\n" + QByteArray::number(xrefOffset) + "\n%%EOF\n";
+    return flush(device, pdf);
+}
+
+bool Vectorizer::write(QIODevice *device, AbstractBarcode::VectorFormat format, const BarcodeMatrix &matrix, const QSizeF &size, QRgb foreground, QRgb background)
+{
+    switch (format) {
+    case AbstractBarcode::SvgFormat:
+        return writeSvg(device, matrix, size, foreground, background);
+    case AbstractBarcode::EpsFormat:
+        return writeEps(device, matrix, size, foreground, background);
+    case AbstractBarcode::PdfFormat:
+        return writePdf(device, matrix, size, foreground, background);
+    }
+    return false;
+}
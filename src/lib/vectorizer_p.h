@@ -0,0 +1,37 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: MIT
+*/
+
+#ifndef PRISON_VECTORIZER_P_H
+#define PRISON_VECTORIZER_P_H
+
+#include "abstractbarcode.h"
+
+#include <QRect>
+#include <QVector>
+
+class QIODevice;
+
+namespace Prison
+{
+class BarcodeMatrix;
+
+/** Converts module matrices into vector shapes. */
+namespace Vectorizer
+{
+/** Covers all set modules of @p matrix with non-overlapping rectangles, in module coordinates.
+ *  Horizontally adjacent modules are merged into runs, and identical runs in consecutive
+ *  rows into a single rectangle.
+ */
+QVector<QRect> rectangles(const BarcodeMatrix &matrix);
+
+/** Writes @p matrix as vector graphics document in @p format to @p device.
+ *  @p size is the size of the output in the document units (pixels for SVG, points for EPS and PDF).
+ */
+bool write(QIODevice *device, AbstractBarcode::VectorFormat format, const BarcodeMatrix &matrix, const QSizeF &size, QRgb foreground, QRgb background);
+}
+}
+
+#endif // PRISON_VECTORIZER_P_H